@@ -0,0 +1,39 @@
+# Turns the offsets files written by `sigresolve --save-offsets` into a header listing every known
+# build of the game, which version.hpp and offsets.hpp expand into exlaunch user versions and reloc tables.
+# A file is named after its build and holds "build <hash>" followed by "<category>/<name> <offset>" lines.
+function(generate_known_builds OFFSETS_DIR OUTPUT)
+  file(GLOB OFFSETS_FILES CONFIGURE_DEPENDS ${OFFSETS_DIR}/*.txt)
+
+  set(KNOWN_BUILDS "")
+  set(KNOWN_BUILD_TABLES "")
+
+  foreach(OFFSETS_FILE ${OFFSETS_FILES})
+    get_filename_component(BUILD_NAME ${OFFSETS_FILE} NAME_WLE)
+    string(MAKE_C_IDENTIFIER ${BUILD_NAME} BUILD_NAME)
+
+    set(BUILD_HASH "")
+    set(ENTRIES "")
+    file(STRINGS ${OFFSETS_FILE} LINES REGEX "^[^#]")
+    foreach(LINE ${LINES})
+      if (NOT LINE MATCHES "^([^ \t]+)[ \t]+(0x[0-9a-fA-F]+)[ \t]*$")
+        message(FATAL_ERROR "${OFFSETS_FILE}: malformed line '${LINE}'")
+      endif ()
+
+      if (CMAKE_MATCH_1 STREQUAL "build")
+        set(BUILD_HASH ${CMAKE_MATCH_2})
+      else ()
+        string(APPEND ENTRIES ", \\\n        { util::ModuleIndex::Main, ${CMAKE_MATCH_2}, \"${CMAKE_MATCH_1}\" }")
+      endif ()
+    endforeach ()
+
+    if (BUILD_HASH STREQUAL "")
+      message(FATAL_ERROR "${OFFSETS_FILE}: missing build hash")
+    endif ()
+
+    string(APPEND KNOWN_BUILDS " \\\n    X(${BUILD_NAME}, ${BUILD_HASH})")
+    string(APPEND KNOWN_BUILD_TABLES " \\\n    , UserTableType<VersionType::${BUILD_NAME}${ENTRIES}>")
+  endforeach ()
+
+  # Only rewritten when it changes, so adding nothing doesn't rebuild everything
+  configure_file(${CMAKE_CURRENT_FUNCTION_LIST_DIR}/known_builds.hpp.in ${OUTPUT} @ONLY)
+endfunction()
@@ -1,157 +1,288 @@
-
-#include <vector>
-#include <concepts>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <span>
 #include <string_view>
 
+#include <cJSON/cJSON.h>
 #include <log/logger_mgr.hpp>
+#include <program/setting.hpp>
+#include <util/murmur3.hpp>
+#include <skyline/nn/fs.h>
 #include <skyline/utils/cpputils.hpp>
 
 #include "Config.h"
+#include "ConfigBlob.h"
+#include "JsonStream.h"
+#include "Trace.h"
 
 namespace rd {
 namespace config {
 
-JsonWrapper::JsonWrapper(JsonWrapper&& other) noexcept : inner(other.inner), takeOwnership(other.takeOwnership) {
-    other.inner = nullptr;
-    other.takeOwnership = false;
-}
-JsonWrapper& JsonWrapper::operator=(JsonWrapper&& other) noexcept {
-    if (this != &other) {
-        if (takeOwnership && inner) {
-            ::cJSON_Delete(inner);
+// Bump allocator cJSON builds a config tree in, rather than a malloc per node and string from the small heap.
+// Grows a block at a time, so it takes what the kept sections need whatever the size of the file.
+// Release frees the whole tree at once.
+class JsonArena {
+  public:
+    static constexpr size_t BlockSize = 0x1000;
+
+    JsonArena() = default;
+    JsonArena(const JsonArena&) = delete;
+    JsonArena& operator=(const JsonArena&) = delete;
+
+    // cJSON allocates from the arena until Release
+    void Begin(const char *fileName) {
+        this->fileName = fileName;
+        s_Current = this;
+        cJSON_Hooks hooks = { Allocate, Free };
+        ::cJSON_InitHooks(&hooks);
+    }
+
+    // Frees the tree along with the arena, and logs how much it took
+    void Release() {
+        if (s_Current != this) return;
+
+        size_t count = 0, reserved = 0;
+        while (blocks != nullptr) {
+            Block *next = blocks->next;
+            count++;
+            reserved += sizeof(Block) + blocks->capacity;
+            free(blocks);
+            blocks = next;
         }
-        inner = other.inner;
-        takeOwnership = other.takeOwnership;
-        other.inner = nullptr;
-        other.takeOwnership = false;
+        ::cJSON_InitHooks(nullptr);
+        s_Current = nullptr;
+
+        Logging.Log("Parsing %s took %lu bytes in %lu blocks, %lu of them used, the heap is %lu\n", fileName, reserved,
+                    count, used, exl::setting::HeapSize);
     }
-    return *this;
-}
 
-JsonWrapper JsonWrapper::operator[](std::string_view item) {
-    return JsonWrapper(::cJSON_GetObjectItem(inner, item.data()));
-}
+  private:
+    // Followed by capacity bytes
+    struct Block {
+        Block *next;
+        size_t capacity;
+        size_t used;
 
-template<> int JsonWrapper::get<int>() {
-    return static_cast<int>(::cJSON_GetNumberValue(inner));
-}
+        uint8_t *Data() { return reinterpret_cast<uint8_t*>(this + 1); }
+    };
 
-template<> size_t JsonWrapper::get<size_t>() {
-    return static_cast<size_t>(::cJSON_GetNumberValue(inner));
-}
+    static constexpr size_t Alignment = 8;  // Nothing in a cJSON tree is wider than a pointer or a double
 
-template<> std::string_view JsonWrapper::get<std::string_view>() {
-    char *ret = ::cJSON_GetStringValue(inner);
-    return ret ? std::string_view { ret } : std::string_view { };
-}
+    static inline JsonArena *s_Current = nullptr;
 
-template<> bool JsonWrapper::get<bool>() {
-    return static_cast<bool>(::cJSON_IsTrue(inner));
-}
+    static void* Allocate(size_t size) {
+        JsonArena &arena = *s_Current;
+        size_t aligned = (size + Alignment - 1) & ~(Alignment - 1);
 
-template<> std::vector<std::string_view> JsonWrapper::get<std::vector<std::string_view>>() {
-    size_t size = (size_t)::cJSON_GetArraySize(inner);
-    auto ret = std::vector<std::string_view>();
-    ret.reserve(size);
+        Block *block = arena.blocks;
+        if (block == nullptr || aligned > block->capacity - block->used) {
+            size_t capacity = std::max(aligned, BlockSize - sizeof(Block));
+            block = static_cast<Block*>(malloc(sizeof(Block) + capacity));
+            if (block == nullptr) return nullptr;
+            *block = { nullptr, capacity, 0 };
 
-    for (size_t i = 0; i < size; i++)
-        ret.emplace_back(JsonWrapper(::cJSON_GetArrayItem(inner, i)).get<std::string_view>());
-    return ret;
-}
+            // A string too long for a block gets one of its own, behind the one still being filled
+            if (capacity > BlockSize - sizeof(Block) && arena.blocks != nullptr) {
+                block->next = arena.blocks->next;
+                arena.blocks->next = block;
+            } else {
+                block->next = arena.blocks;
+                arena.blocks = block;
+            }
+        }
 
-template<> std::vector<JsonWrapper> JsonWrapper::get<std::vector<JsonWrapper>>() {
-    size_t size = (size_t)::cJSON_GetArraySize(inner);
-    auto ret = std::vector<JsonWrapper>();
-    ret.reserve(size);
+        arena.last = block->Data() + block->used;
+        arena.lastBlock = block;
+        block->used += aligned;
+        arena.used += aligned;
+        return arena.last;
+    }
 
-    for (size_t i = 0; i < size; i++) ret.emplace_back(::cJSON_GetArrayItem(inner, i));
+    static void Free(void *ptr) {
+        // Only the latest allocation can be given back, such as the key of a member cJSON failed to add
+        JsonArena &arena = *s_Current;
+        if (ptr == nullptr || ptr != arena.last) return;
 
-    return ret;
-}
+        size_t start = arena.last - arena.lastBlock->Data();
+        arena.used -= arena.lastBlock->used - start;
+        arena.lastBlock->used = start;
+        arena.last = nullptr;
+    }
 
-template<> float JsonWrapper::get<float>() {
-    return static_cast<float>(::cJSON_GetNumberValue(inner));
-}
+    const char *fileName = nullptr;
+    Block *blocks = nullptr;  // The one being filled first
+    uint8_t *last = nullptr;
+    Block *lastBlock = nullptr;
+    size_t used = 0;
+};
 
-std::string_view JsonWrapper::getName() const {
-    return std::string_view { this->inner->string ? this->inner->string : "" };
-}
+// Config files are read this much at a time, only what's kept of them outlives a chunk
+static constexpr size_t ChunkSize = 0x1000;
+static char s_Chunk[ChunkSize];
 
-bool JsonWrapper::has(std::string_view item) {
-    return ::cJSON_HasObjectItem(inner, item.data()) == 1;
-}
+// Reads one of the romfs config files a chunk at a time into a tree in arena that only has the root members in keep,
+// nullptr once it's logged why it couldn't. hash gets the Murmur3 of the whole file.
+// The trace name is kept as it is, so it's a literal.
+static cJSON* StreamJson(std::string const &path, JsonArena &arena, const char *fileName, const char *traceName,
+                         std::span<const std::string_view> keep, uint32_t *hash = nullptr) {
+    trace::Span span("config", traceName);
+
+    nn::fs::FileHandle handle;
+    s64 size = 0;
+    Result rc = nn::fs::OpenFile(&handle, path.c_str(), nn::fs::OpenMode_Read);
+    if (R_SUCCEEDED(rc)) {
+        rc = nn::fs::GetFileSize(&size, handle);
+        if (R_FAILED(rc)) nn::fs::CloseFile(handle);
+    }
+    if (R_FAILED(rc)) {
+        Logging.Log("Failed to load %s: 0x%x\n", fileName, rc);
+        return nullptr;
+    }
+
+    arena.Begin(fileName);
+    JsonStream stream(keep);
+    exl::util::Murmur3 murmur;
+    murmur.Initialize();
 
-void JsonWrapper::print() {
-    auto jsonString = ::cJSON_Print(inner);
-    Logging.Log("%s\n", jsonString);
-    free(jsonString);
+    std::string error;
+    bool ok = true;
+    for (s64 offset = 0; ok && offset < size; offset += ChunkSize) {
+        size_t chunkSize = std::min<s64>(ChunkSize, size - offset);
+        rc = nn::fs::ReadFile(handle, offset, s_Chunk, chunkSize);
+        if (R_FAILED(rc)) {
+            Logging.Log("Failed to read %s: 0x%x\n", fileName, rc);
+            nn::fs::CloseFile(handle);
+            return nullptr;
+        }
+
+        // Every chunk but the last is a whole number of Murmur3 blocks
+        size_t blocks = chunkSize / sizeof(uint32_t) * sizeof(uint32_t);
+        for (size_t i = 0; i < blocks; i += sizeof(uint32_t)) {
+            uint32_t block;
+            memcpy(&block, s_Chunk + i, sizeof(block));
+            murmur.Update(block);
+        }
+        if (hash && offset + (s64)chunkSize == size)
+            *hash = murmur.Finalize(std::span<const char>(s_Chunk + blocks, chunkSize - blocks));
+
+        ok = stream.Feed({ s_Chunk, chunkSize }, error);
+    }
+    nn::fs::CloseFile(handle);
+
+    cJSON *root = ok ? stream.Finish(error) : nullptr;
+    if (root == NULL) Logging.Log("Failed to parse %s: %s", fileName, error.c_str());
+    else Logging.Log("Successfully parsed %s: size(%ld)\n", fileName, size);
+    return root;
 }
 
-void Init(std::string const &romMount) {
-    const char *contents;
-    size_t contentsSize;
-    Result rc = skyline::utils::readEntireFile(romMount + "system/gamedef.json", (void**)(&contents), &contentsSize);
-    
+// Reads config.bin into contents, nullptr once it's logged why it can't be used. The signatures in contents
+// point into the buffer returned, which the caller frees.
+static const uint8_t* LoadBlob(std::string const &path, BlobContents &contents) {
+    const uint8_t *buffer;
+    size_t size;
+    uint64_t start = trace::Now();
+    Result rc = skyline::utils::readEntireFile(path, (void**)(&buffer), &size);
+    trace::Record("config", "read config.bin", start, trace::Now());
+
     if (R_FAILED(rc)) {
-        Logging.Log("Failed to load gamedef.json: 0x%x\n", rc);
-        return;
-    }
-    
-    Logging.Log("Successfully loaded gamedef.json: size(%d)\n", contentsSize);
-    ::cJSON_InitHooks(nullptr);
-    cJSON *inner = ::cJSON_CreateObject();
-    cJSON *parseResult = cJSON_ParseWithLength(contents, contentsSize);
-    if (parseResult == NULL) {
-        Logging.Log("Failed to parse gamedef.json: %s\n", ::cJSON_GetErrorPtr());
-        free((void*)contents);
-        return;
+        Logging.Log("No config.bin (0x%x)\n", rc);
+        return nullptr;
     }
 
-    bool result = ::cJSON_AddItemToObject(inner, "gamedef", parseResult);
-    if (!result || inner == NULL) {
-        Logging.Log("Failed to parse gamedef.json: %s\n", ::cJSON_GetErrorPtr());
-        goto cleanup;
-    } else {
-        Logging.Log("Successfully parsed gamedef.json\n");
+    std::string error;
+    {
+        trace::Span span("config", "load config.bin");
+        if (!ReadBlob({ buffer, size }, contents, error)) {
+            Logging.Log("Ignoring config.bin: %s", error.c_str());
+            free((void*)buffer);
+            return nullptr;
+        }
     }
 
-    free((void*)contents);
+    Logging.Log("Loaded config.bin: size(%lu), %lu signatures\n", size, contents.signatures.size());
+    return buffer;
+}
 
-    rc = skyline::utils::readEntireFile(romMount + "system/patchdef.json", (void**)(&contents), &contentsSize);
-    
-    if (R_FAILED(rc)) {
-        Logging.Log("Failed to load patchdef.json: 0x%x\n", rc);
-        goto exit;
+// config.bin, see ConfigBlob.h. False when the JSON files should be read instead.
+static bool ReadBlobFile(std::string const &path) {
+    BlobContents blob;
+    const uint8_t *buffer = LoadBlob(path, blob);
+    if (buffer == nullptr) {
+        Logging.Log("Reading gamedef.json and patchdef.json\n");
+        return false;
     }
 
-    Logging.Log("Successfully loaded patchdef.json: size(%d)\n", contentsSize);
+    config.blob = buffer;
+    config.gamedefHash = blob.gamedefHash;
+    config.signatures = std::move(blob.signatures);
+    config.patchdef = std::move(blob.patchdef);
+    return true;
+}
+
+// patchdef.json's "base", customInstructions included
+static constexpr std::string_view PatchdefSections[] = { "base" };
 
-    parseResult = cJSON_ParseWithLength(contents, contentsSize);
-    if (parseResult == NULL) {
-        Logging.Log("Failed to parse patchdef.json: %s\n", ::cJSON_GetErrorPtr());
-        goto exit;
+void Init(std::string const &romMount) {
+    ::cJSON_InitHooks(nullptr);
+    if (ReadBlobFile(romMount + "system/config.bin")) return;
+
+    static constexpr std::string_view GamedefSections[] = { "signatures" };
+    JsonArena gamedefArena;
+    cJSON *gamedef = StreamJson(romMount + "system/gamedef.json", gamedefArena, "gamedef.json", "read gamedef.json",
+                                GamedefSections, &config.gamedefHash);
+    if (gamedef != NULL) {
+        trace::Span span("config", "compile signatures");
+        std::vector<std::string> errors;
+        config.signatures = rd::hook::CompileSignatures(::cJSON_GetObjectItem(gamedef, "signatures"), errors);
+        for (const std::string& error : errors) Logging.Log(error);
+
+        rd::hook::InternStrings(config.signatures, config.strings);
+        Logging.Log("Compiled %lu signatures\n", config.signatures.size());
     }
+    gamedefArena.Release();
+    if (gamedef == NULL) return;
 
-    result = ::cJSON_AddItemToObject(inner, "patchdef", parseResult);
-    if (!result || inner == NULL) {
-        Logging.Log("Failed to parse patchdef.json: %s\n", ::cJSON_GetErrorPtr());
+    JsonArena patchdefArena;
+    cJSON *patchdef = StreamJson(romMount + "system/patchdef.json", patchdefArena, "patchdef.json",
+                                 "read patchdef.json", PatchdefSections);
+    if (patchdef != NULL) config.patchdef = ReadPatchdef(::cJSON_GetObjectItem(patchdef, "base"));
+    patchdefArena.Release();
+}
+
+// Freed by the reload after the one that replaced it: a hook holds a snapshot for one call, and reloads are
+// at least a poll apart
+static const Patchdef *s_Retired = nullptr;
+
+bool ReloadPatchdef(std::string const &romMount) {
+    trace::Span span("config", "reload patchdef");
+    Patchdef *patchdef = nullptr;
+
+    if (config.blob != nullptr) {
+        BlobContents blob;
+        const uint8_t *buffer = LoadBlob(romMount + "system/config.bin", blob);
+        if (buffer == nullptr) return false;
+
+        patchdef = new Patchdef(std::move(blob.patchdef));
+        blob.signatures.clear();  // They point into buffer
+        free((void*)buffer);
     } else {
-        Logging.Log("Successfully parsed patchdef.json\n");
+        JsonArena arena;
+        cJSON *root = StreamJson(romMount + "system/patchdef.json", arena, "patchdef.json", "read patchdef.json",
+                                 PatchdefSections);
+        if (root != NULL) patchdef = new Patchdef(ReadPatchdef(::cJSON_GetObjectItem(root, "base")));
+        arena.Release();
+        if (patchdef == nullptr) return false;
     }
 
-exit:
-    config = JsonWrapper(inner, true);
-cleanup:
-    free((void*)contents);
-}
+    const Patchdef *previous = livePatchdef.exchange(patchdef, std::memory_order_acq_rel);
+    if (s_Retired != &config.patchdef) delete s_Retired;
+    s_Retired = previous;
 
-template int JsonWrapper::get<int>();
-template size_t JsonWrapper::get<size_t>();
-template std::string_view JsonWrapper::get<std::string_view>();
-template std::vector<std::string_view> JsonWrapper::get<std::vector<std::string_view>>();
-template bool JsonWrapper::get<bool>();
-template float JsonWrapper::get<float>();
-template std::vector<JsonWrapper> JsonWrapper::get<std::vector<JsonWrapper>>();
+    Logging.Log("Reloaded the patchdef: atlasDialogueMargin %f, atlasOutlineMargin %f, dialogueOutlineOffset %f\n",
+                patchdef->atlasDialogueMargin, patchdef->atlasOutlineMargin, patchdef->dialogueOutlineOffset);
+    return true;
+}
 
 }  // namespace config
-}  // namespace rd
\ No newline at end of file
+}  // namespace rd
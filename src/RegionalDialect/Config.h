@@ -1,45 +1,47 @@
 #pragma once
 
+#include <atomic>
 #include <string>
 #include <string_view>
+#include <vector>
 
-#include <cJSON/cJSON.h>
 #include <lib/log/logger_mgr.hpp>
 
+#include "Patchdef.h"
+#include "Signature.h"
+
 namespace rd {
 namespace config {
 
-    class JsonWrapper {
-       private:
-        cJSON* inner{};
-        bool takeOwnership = false;
-
-       public:
-        JsonWrapper() = default;
-        JsonWrapper(cJSON* inner, bool takeOwnership = false) : inner(inner), takeOwnership(takeOwnership) {}
-        JsonWrapper(JsonWrapper const&) = delete;             // Disable copy constructor
-        JsonWrapper& operator=(JsonWrapper const&) = delete;  // Disable copy assignment
-        JsonWrapper(JsonWrapper&& other) noexcept;
-        JsonWrapper& operator=(JsonWrapper&& other) noexcept;
-        ~JsonWrapper() {
-            if (takeOwnership && inner) {
-                ::cJSON_Delete(inner);
-                Logging.Log("JsonWrapper deleted cJSON object.\n");
-            }
-        }
-        cJSON const* raw() const { return inner; }
-        JsonWrapper operator[](std::string_view item);
-
-        template <typename T>
-        T get();
-        bool has(std::string_view item);
-        std::string_view getName() const;
-        void print();
+    // Everything the config files say, read once at startup. Comes from config.bin when there is one,
+    // otherwise from the JSON files, whose cJSON trees are freed as soon as they're read.
+    struct Snapshot {
+        // Murmur3 of the raw gamedef.json, tells whether its signatures changed between launches
+        uint32_t gamedefHash = 0;
+
+        // The gamedef's "signatures", compiled and sorted by category and name. hook::Init takes them over.
+        std::vector<rd::hook::CompiledSignature> signatures;
+        rd::hook::StringPool strings;   // What the signatures' names and pattern text point into
+        const uint8_t* blob = nullptr;  // Or config.bin, kept for as long as the signatures are
+
+        Patchdef patchdef;
     };
 
-    inline JsonWrapper config;
+    inline Snapshot config;
+
+    // The patchdef hooks read their settings from, config.patchdef until a reload publishes a new one.
+    // Snapshots are never changed once published, and the one a hook loaded stays valid until it returns.
+    inline std::atomic<const Patchdef*> livePatchdef = &config.patchdef;
+
+    inline const Patchdef& Live() {
+        return *livePatchdef.load(std::memory_order_acquire);
+    }
 
     void Init(std::string const &romMount);
 
+    // Reads the patchdef again, from config.bin if that's what Init loaded, and publishes it as Live().
+    // False once it's logged why it couldn't, Live() then stays as it was.
+    bool ReloadPatchdef(std::string const &romMount);
+
 }  // namespace config
 }  // namespace rd
@@ -0,0 +1,304 @@
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+#include "ConfigBlob.h"
+
+using namespace std;
+using namespace rd::hook;
+
+namespace rd {
+namespace config {
+
+namespace {
+
+// Lays the tables out first and everything they point at after them, so every offset is known when it's written
+class BlobWriter {
+  public:
+    explicit BlobWriter(uint32_t dataStart) : dataStart(dataStart) {}
+
+    // The same text is only stored once
+    BlobString AddString(string_view text) {
+        auto it = strings.find(text);
+        if (it != strings.end()) return it->second;
+
+        BlobString ret = { Offset(), static_cast<uint32_t>(text.size()) };
+        data.insert(data.end(), text.begin(), text.end());
+        data.push_back('\0');
+        strings.emplace(text, ret);
+        return ret;
+    }
+
+    uint32_t AddBytes(const uint8_t* bytes, size_t size) {
+        data.resize((Offset() + PatternView::VectorSize - 1) / PatternView::VectorSize * PatternView::VectorSize - dataStart);
+        uint32_t ret = Offset();
+        data.insert(data.end(), bytes, bytes + size);
+        return ret;
+    }
+
+    vector<uint8_t>& Data() { return data; }
+
+  private:
+    uint32_t Offset() const { return dataStart + data.size(); }
+
+    uint32_t dataStart;
+    vector<uint8_t> data;
+    unordered_map<string_view, BlobString> strings;
+};
+
+template <typename T>
+void Place(vector<uint8_t>& blob, BlobRange range, const vector<T>& records) {
+    if (!records.empty()) memcpy(blob.data() + range.offset, records.data(), records.size() * sizeof(T));
+}
+
+}  // namespace
+
+vector<uint8_t> WriteBlob(span<const CompiledSignature> signatures, const Patchdef& patchdef, uint32_t gamedefHash) {
+    BlobHeader header = {};
+    header.magic = BlobMagic;
+    header.version = BlobVersion;
+    header.gamedefHash = gamedefHash;
+
+    uint32_t patternCount = 0, opCount = 0;
+    for (const CompiledSignature& sig : signatures) {
+        patternCount += sig.patterns.size();
+        opCount += sig.expr.Program().size();
+    }
+
+    uint32_t offset = sizeof(BlobHeader);
+    auto table = [&](BlobRange& range, uint32_t count, size_t recordSize) {
+        range = { offset, count };
+        offset += count * recordSize;
+    };
+    table(header.signatures, signatures.size(), sizeof(BlobSignature));
+    table(header.patterns, patternCount, sizeof(BlobPattern));
+    table(header.ops, opCount, sizeof(BlobOp));
+    table(header.instructions, patchdef.instructions.size(), sizeof(BlobInstruction));
+
+    BlobWriter writer(offset);
+    vector<BlobSignature> sigRecords;
+    vector<BlobPattern> patternRecords;
+    vector<BlobOp> opRecords;
+    vector<BlobInstruction> instructionRecords;
+
+    for (const CompiledSignature& sig : signatures) {
+        BlobSignature& record = sigRecords.emplace_back();
+        record = {};
+        record.category = writer.AddString(sig.category);
+        record.name = writer.AddString(sig.name);
+        record.expr = writer.AddString(sig.expr.Input());
+        record.offset = sig.offset;
+        record.occurrence = sig.occurrence;
+        record.isArray = sig.isArray;
+
+        record.segment = static_cast<uint8_t>(sig.scope.segment);
+        record.windowStart = sig.scope.windowStart;
+        record.windowEnd = sig.scope.windowEnd;
+        record.within = sig.scope.within;
+        record.nearCategory = writer.AddString(sig.scope.nearCategory);
+        record.nearName = writer.AddString(sig.scope.nearName);
+
+        record.xrefKind = static_cast<uint8_t>(sig.xref.kind);
+        record.xrefCategory = writer.AddString(sig.xref.category);
+        record.xrefName = writer.AddString(sig.xref.name);
+        record.xrefValue = sig.xref.value;
+
+        record.patterns = { static_cast<uint32_t>(patternRecords.size()), static_cast<uint32_t>(sig.patterns.size()) };
+        for (const CompiledPattern& compiled : sig.patterns) {
+            const PatternView& view = compiled.pattern.view;
+            BlobPattern& pattern = patternRecords.emplace_back();
+            pattern = {};
+            pattern.text = writer.AddString(compiled.text);
+            pattern.value = writer.AddBytes(view.value, view.paddedSize);
+            pattern.mask = writer.AddBytes(view.mask, view.paddedSize);
+            pattern.size = view.size;
+            pattern.paddedSize = view.paddedSize;
+            pattern.anchor = view.anchor;
+            pattern.anchor2 = view.anchor2;
+            pattern.hasAnchor = view.hasAnchor;
+            pattern.alignment = view.alignment;
+        }
+
+        record.ops = { static_cast<uint32_t>(opRecords.size()), static_cast<uint32_t>(sig.expr.Program().size()) };
+        for (const SigExprOp& op : sig.expr.Program()) {
+            BlobOp& blobOp = opRecords.emplace_back();
+            blobOp = {};
+            blobOp.code = static_cast<uint8_t>(op.code);
+            blobOp.value = op.value;
+        }
+    }
+
+    for (const CustomInstruction& inst : patchdef.instructions)
+        instructionRecords.push_back({ writer.AddString(inst.name), inst.table, inst.opcode });
+
+    for (size_t i = 0; i < size(BlobFlags); i++)
+        if (patchdef.*BlobFlags[i]) header.flags |= 1u << i;
+    header.atlasDialogueMargin = patchdef.atlasDialogueMargin;
+    header.atlasOutlineMargin = patchdef.atlasOutlineMargin;
+    header.dialogueOutlineOffset = patchdef.dialogueOutlineOffset;
+    header.nametagOptionLayout = writer.AddString(patchdef.nametagOptionLayout);
+    header.size = offset + writer.Data().size();
+
+    vector<uint8_t> blob(header.size);
+    memcpy(blob.data(), &header, sizeof(header));
+    Place(blob, header.signatures, sigRecords);
+    Place(blob, header.patterns, patternRecords);
+    Place(blob, header.ops, opRecords);
+    Place(blob, header.instructions, instructionRecords);
+    memcpy(blob.data() + offset, writer.Data().data(), writer.Data().size());
+    return blob;
+}
+
+bool ReadBlob(span<const uint8_t> blob, BlobContents& contents, string& error) {
+    if (blob.size() < sizeof(BlobHeader) || reinterpret_cast<uintptr_t>(blob.data()) % alignof(uint64_t) != 0) {
+        error = "Too small or misaligned to be a config blob.\n";
+        return false;
+    }
+
+    const BlobHeader& header = *reinterpret_cast<const BlobHeader*>(blob.data());
+    if (header.magic != BlobMagic) {
+        error = "Not a config blob.\n";
+        return false;
+    }
+    if (header.version != BlobVersion) {
+        error = "Config blob version " + to_string(header.version) + ", this build reads version " +
+                to_string(BlobVersion) + ". Compile it again with rdconfig.\n";
+        return false;
+    }
+    if (header.size != blob.size()) {
+        error = "Config blob of " + to_string(blob.size()) + " bytes, its header says " + to_string(header.size) + ".\n";
+        return false;
+    }
+
+    auto table = [&]<typename T>(BlobRange range, span<const T>& out) {
+        if (range.offset % alignof(T) != 0 || range.offset > blob.size() ||
+            range.count > (blob.size() - range.offset) / sizeof(T))
+            return false;
+        out = { reinterpret_cast<const T*>(blob.data() + range.offset), range.count };
+        return true;
+    };
+    auto subrange = [](BlobRange range, size_t count) {
+        return range.offset <= count && range.count <= count - range.offset;
+    };
+    auto text = [&](BlobString str, string_view& out) {
+        if (str.offset >= blob.size() || str.size >= blob.size() - str.offset || blob[str.offset + str.size] != '\0')
+            return false;
+        out = { reinterpret_cast<const char*>(blob.data() + str.offset), str.size };
+        return true;
+    };
+    auto bytes = [&](uint32_t offset, uint32_t size) {
+        return offset % PatternView::VectorSize == 0 && offset <= blob.size() && size <= blob.size() - offset;
+    };
+
+    span<const BlobSignature> signatures;
+    span<const BlobPattern> patterns;
+    span<const BlobOp> ops;
+    span<const BlobInstruction> instructions;
+    if (!table(header.signatures, signatures) || !table(header.patterns, patterns) || !table(header.ops, ops) ||
+        !table(header.instructions, instructions)) {
+        error = "A table of the config blob is out of bounds.\n";
+        return false;
+    }
+
+    contents.gamedefHash = header.gamedefHash;
+    contents.signatures.clear();
+    contents.signatures.reserve(signatures.size());
+
+    for (size_t i = 0; i < signatures.size(); i++) {
+        const BlobSignature& record = signatures[i];
+        CompiledSignature& sig = contents.signatures.emplace_back();
+        string_view expr;
+
+        bool ok = text(record.category, sig.category) && text(record.name, sig.name) && text(record.expr, expr) &&
+                  text(record.nearCategory, sig.scope.nearCategory) && text(record.nearName, sig.scope.nearName) &&
+                  text(record.xrefCategory, sig.xref.category) && text(record.xrefName, sig.xref.name) &&
+                  subrange(record.patterns, patterns.size()) && subrange(record.ops, ops.size()) &&
+                  record.segment <= static_cast<uint8_t>(SigSegment::Data) &&
+                  record.xrefKind <= static_cast<uint8_t>(SigXRef::Kind::To);
+        if (!ok) {
+            error = "Signature " + to_string(i) + " of the config blob is malformed.\n";
+            return false;
+        }
+
+        sig.isArray = record.isArray;
+        sig.offset = record.offset;
+        sig.occurrence = record.occurrence;
+        sig.scope.segment = static_cast<SigSegment>(record.segment);
+        sig.scope.windowStart = record.windowStart;
+        sig.scope.windowEnd = record.windowEnd;
+        sig.scope.within = record.within;
+        sig.xref.kind = static_cast<SigXRef::Kind>(record.xrefKind);
+        sig.xref.value = record.xrefValue;
+
+        sig.patterns.reserve(record.patterns.count);
+        for (const BlobPattern& pattern : patterns.subspan(record.patterns.offset, record.patterns.count)) {
+            CompiledPattern& compiled = sig.patterns.emplace_back();
+            bool anchored = !pattern.hasAnchor ||
+                            (pattern.anchor < pattern.size && pattern.anchor2 < pattern.size &&
+                             (pattern.alignment != 4 || pattern.anchor + 4 <= pattern.size));
+            if (!text(pattern.text, compiled.text) || !bytes(pattern.value, pattern.paddedSize) ||
+                !bytes(pattern.mask, pattern.paddedSize) || pattern.paddedSize % PatternView::VectorSize != 0 ||
+                pattern.size > pattern.paddedSize || (pattern.alignment != 1 && pattern.alignment != 4) || !anchored) {
+                error = "A pattern of " + string(sig.category) + "/" + string(sig.name) + " in the config blob is malformed.\n";
+                return false;
+            }
+
+            PatternView& view = compiled.pattern.view;
+            view.value = blob.data() + pattern.value;
+            view.mask = blob.data() + pattern.mask;
+            view.size = pattern.size;
+            view.paddedSize = pattern.paddedSize;
+            view.anchor = pattern.anchor;
+            view.anchor2 = pattern.anchor2;
+            view.hasAnchor = pattern.hasAnchor;
+            view.alignment = pattern.alignment;
+        }
+
+        vector<SigExprOp> program;
+        program.reserve(record.ops.count);
+        for (const BlobOp& op : ops.subspan(record.ops.offset, record.ops.count))
+            program.push_back({ static_cast<SigExprOpCode>(op.code), static_cast<uintptr_t>(op.value) });
+        if (!sig.expr.Load(expr, program)) {
+            error = "The expr of " + string(sig.category) + "/" + string(sig.name) + " in the config blob is malformed.\n";
+            return false;
+        }
+    }
+
+    bool sorted = is_sorted(contents.signatures.begin(), contents.signatures.end(),
+                            [](const CompiledSignature& a, const CompiledSignature& b) {
+                                return pair(a.category, a.name) < pair(b.category, b.name);
+                            });
+    if (!sorted) {
+        error = "The config blob's signatures aren't sorted.\n";
+        return false;
+    }
+
+    Patchdef& patchdef = contents.patchdef;
+    patchdef = {};
+    for (size_t i = 0; i < size(BlobFlags); i++) patchdef.*BlobFlags[i] = header.flags & (1u << i);
+    patchdef.atlasDialogueMargin = header.atlasDialogueMargin;
+    patchdef.atlasOutlineMargin = header.atlasOutlineMargin;
+    patchdef.dialogueOutlineOffset = header.dialogueOutlineOffset;
+
+    string_view layout;
+    if (!text(header.nametagOptionLayout, layout)) {
+        error = "The config blob's nametagOptionLayout is out of bounds.\n";
+        return false;
+    }
+    patchdef.nametagOptionLayout = layout;
+
+    for (const BlobInstruction& inst : instructions) {
+        string_view name;
+        if (!text(inst.name, name)) {
+            error = "A custom instruction's name in the config blob is out of bounds.\n";
+            return false;
+        }
+        patchdef.instructions.push_back({ .name = string(name), .table = inst.table, .opcode = inst.opcode });
+    }
+    patchdef.customInstructions = !patchdef.instructions.empty();
+
+    return true;
+}
+
+}  // namespace config
+}  // namespace rd
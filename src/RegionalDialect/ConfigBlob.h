@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "Patchdef.h"
+#include "Signature.h"
+
+namespace rd {
+namespace config {
+
+    // config.bin, gamedef.json and patchdef.json compiled ahead of time by tools/rdconfig.
+    // Read into one buffer and used where it is: signatures point into it instead of at strings of their own,
+    // and patterns and expressions are already compiled. Offsets are from the start of the blob, so it can be
+    // loaded anywhere 8-byte aligned. Little-endian, like both the Switch and the hosts the tools run on.
+    //
+    // Header, then the signature, pattern, op and instruction tables, then the strings, each null-terminated,
+    // and the pattern bytes, each 16-byte aligned and padded like Pattern pads them.
+    inline constexpr uint32_t BlobMagic = 0x46434452;  // "RDCF"
+    inline constexpr uint32_t BlobVersion = 1;         // Bump on any change to the layout below
+
+    struct BlobRange {
+        uint32_t offset = 0;
+        uint32_t count = 0;
+    };
+
+    struct BlobString {
+        uint32_t offset = 0;
+        uint32_t size = 0;  // Without the terminator
+    };
+
+    struct BlobHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t size;         // Of the whole blob
+        uint32_t gamedefHash;  // Of the gamedef.json it was compiled from, see Snapshot::gamedefHash
+
+        BlobRange signatures;    // BlobSignature, sorted by category and name
+        BlobRange patterns;      // BlobPattern
+        BlobRange ops;           // BlobOp
+        BlobRange instructions;  // BlobInstruction
+
+        uint32_t flags;  // Patchdef switches, bit i for BlobFlags[i]
+        float atlasDialogueMargin;
+        float atlasOutlineMargin;
+        float dialogueOutlineOffset;
+        BlobString nametagOptionLayout;
+    };
+
+    struct BlobSignature {
+        BlobString category;
+        BlobString name;
+        BlobString expr;
+        BlobRange patterns;  // Indices into BlobHeader::patterns
+        BlobRange ops;       // Indices into BlobHeader::ops, the expr compiled
+        uint64_t offset;
+        int32_t occurrence;
+        uint8_t isArray;
+        uint8_t segment;   // SigSegment
+        uint8_t xrefKind;  // SigXRef::Kind
+        uint8_t reserved;
+        uint64_t windowStart;
+        uint64_t windowEnd;
+        uint64_t within;
+        BlobString nearCategory;
+        BlobString nearName;
+        BlobString xrefCategory;
+        BlobString xrefName;
+        uint64_t xrefValue;
+    };
+
+    struct BlobPattern {
+        BlobString text;
+        uint32_t value;  // paddedSize bytes each
+        uint32_t mask;
+        uint32_t size;
+        uint32_t paddedSize;
+        uint32_t anchor;
+        uint32_t anchor2;
+        uint8_t hasAnchor;
+        uint8_t alignment;
+        uint8_t reserved[6];
+    };
+
+    struct BlobOp {
+        uint8_t code;  // SigExprOpCode
+        uint8_t reserved[7];
+        uint64_t value;
+    };
+
+    struct BlobInstruction {
+        BlobString name;
+        int32_t table;
+        int32_t opcode;
+    };
+
+    static_assert(sizeof(BlobHeader) == 72 && sizeof(BlobSignature) == 120 && sizeof(BlobPattern) == 40 &&
+                  sizeof(BlobOp) == 16 && sizeof(BlobInstruction) == 16);
+
+    // The patchdef switches in BlobHeader::flags, customInstructions follows from the instructions
+    inline constexpr bool Patchdef::*BlobFlags[] = {
+        &Patchdef::hookText,           &Patchdef::outlinedFont,        &Patchdef::addNametags,
+        &Patchdef::addBacklogOutline,  &Patchdef::tipReimplementation, &Patchdef::chnRedoChat,
+    };
+
+    // What a config.bin holds. The signatures point into the blob, which must outlive them.
+    struct BlobContents {
+        uint32_t gamedefHash = 0;
+        std::vector<rd::hook::CompiledSignature> signatures;
+        Patchdef patchdef;
+    };
+
+    // The signatures must be sorted, as CompileSignatures leaves them
+    std::vector<uint8_t> WriteBlob(std::span<const rd::hook::CompiledSignature> signatures, const Patchdef& patchdef,
+                                   uint32_t gamedefHash);
+
+    // Checks every offset in the blob before using it, fails with the reason in error
+    bool ReadBlob(std::span<const uint8_t> blob, BlobContents& contents, std::string& error);
+
+}  // namespace config
+}  // namespace rd
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+
+namespace rd {
+namespace mem {
+
+    // Page an ADRP at address points to, immhi:immlo pages away from its own page
+    constexpr uintptr_t DecodeAdrp(uintptr_t address, uint32_t inst) {
+        uint64_t immhi = (inst >> 5) & 0x7FFFF;
+        uint64_t immlo = (inst >> 29) & 0b11;
+        int64_t pages = static_cast<int64_t>(((immhi << 2) | immlo) << 43) >> 43;
+        return (address & ~uintptr_t(0xFFF)) + (pages << 12);
+    }
+
+    // Offset a load/store (unsigned immediate) adds to its base register, imm12 scaled by the access size.
+    // 128-bit SIMD accesses share size 0 with byte ones, opc tells them apart.
+    constexpr uint32_t DecodeLoadStoreOffset(uint32_t inst) {
+        uint32_t scale = (inst >> 30) & 0b11;
+        if ((inst & 0x04800000) == 0x04800000 && scale == 0) scale = 4;
+        return ((inst >> 10) & 0xFFF) << scale;
+    }
+
+    // The pointer an ADRP and the load after it form, decoded the way gamedef exprs and AssemblePointer always
+    // have: immhi's low 13 bits, unsigned, and the offset scaled by the size field alone. Gamedefs are written
+    // against this, so it doesn't follow the exact decoding above that the xref index uses.
+    constexpr uintptr_t DecodePointer(uintptr_t address, uint32_t adrp, uint32_t load) {
+        uint64_t immhi = (adrp >> 5) & 0x1FFF;
+        uint64_t immlo = (adrp >> 29) & 0b11;
+        uintptr_t page = (address & ~uintptr_t(0xFFF)) + (((immhi << 2) | immlo) << 12);
+        return page + (((load >> 10) & 0xFFF) << ((load >> 30) & 0b11));
+    }
+
+    constexpr bool IsAdrp(uint32_t inst) { return (inst & 0x9F000000) == 0x90000000; }
+
+    // ADD Xd, Xn, #imm{, LSL #12}
+    constexpr bool IsAddImmediate64(uint32_t inst) { return (inst & 0xFF800000) == 0x91000000; }
+
+    constexpr uint32_t DecodeAddImmediate(uint32_t inst) {
+        return ((inst >> 10) & 0xFFF) << ((inst >> 22) & 1 ? 12 : 0);
+    }
+
+    // LDR/STR and friends with an unsigned immediate offset, general purpose or SIMD
+    constexpr bool IsLoadStoreUnsignedOffset(uint32_t inst) { return (inst & 0x3B000000) == 0x39000000; }
+
+    constexpr uint32_t Rd(uint32_t inst) { return inst & 0x1F; }
+    constexpr uint32_t Rn(uint32_t inst) { return (inst >> 5) & 0x1F; }
+
+}  // namespace mem
+}  // namespace rd
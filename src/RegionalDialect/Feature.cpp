@@ -0,0 +1,194 @@
+#include <log/logger_mgr.hpp>
+
+#include "Config.h"
+#include "Feature.h"
+#include "Hook.h"
+#include "Mem.h"
+#include "System.h"
+#include "Text.h"
+#include "Trace.h"
+#include "Vm.h"
+
+namespace rd {
+namespace feature {
+
+// Every subsystem's modules, in the order they're listed in
+static std::span<const Module> (*const Subsystems[])() = {
+    rd::sys::Modules,
+    rd::vm::Modules,
+    rd::text::Modules,
+};
+
+enum class State { Unvisited, Visiting, Selected, Off };
+
+struct Entry {
+    const Module* module;
+    State state = State::Unvisited;
+    bool started = false;  // Initialized at startup
+    bool enabled = false;  // Its hooks are in, while started
+    size_t firstHook = 0;  // Its hooks in rd::hook::InstalledHooks()
+    size_t hookCount = 0;
+    size_t patchCount = 0;  // Code it overwrote, which stays when it's turned off
+};
+
+static std::vector<Entry> s_Entries;
+static std::vector<Entry*> s_Selected;  // Dependencies first
+
+template <typename F>
+static void ForEachToken(const char* list, F&& func) {
+    std::string_view rest = list ? list : "";
+    while (!rest.empty()) {
+        size_t start = rest.find_first_not_of(' ');
+        if (start == std::string_view::npos) break;
+        rest.remove_prefix(start);
+
+        size_t end = rest.find(' ');
+        func(rest.substr(0, end));
+        rest.remove_prefix(end == std::string_view::npos ? rest.size() : end);
+    }
+}
+
+static size_t CountTokens(const char* list) {
+    size_t count = 0;
+    ForEachToken(list, [&](std::string_view) { count++; });
+    return count;
+}
+
+static Entry* FindEntry(std::string_view name) {
+    for (Entry& entry : s_Entries)
+        if (entry.module->name == name) return &entry;
+    return nullptr;
+}
+
+// Selects a module and everything it depends on, false if it can't run
+static bool Require(Entry& entry, const rd::config::Patchdef& patchdef, std::vector<Entry*>& selected) {
+    const Module& module = *entry.module;
+    switch (entry.state) {
+        case State::Selected:
+            return true;
+        case State::Off:
+            return false;
+        case State::Visiting:
+            Logging.Log("Feature: %s depends on itself, leaving it off\n", module.name);
+            return false;
+        case State::Unvisited:
+            break;
+    }
+
+    bool wanted = module.activation != Activation::Option || patchdef.*module.option;
+    if (!wanted) {
+        entry.state = State::Off;
+        return false;
+    }
+
+    entry.state = State::Visiting;
+    bool ok = true;
+    ForEachToken(module.dependsOn, [&](std::string_view name) {
+        if (!ok) return;
+
+        Entry* dependency = FindEntry(name);
+        if (dependency == nullptr) {
+            Logging.Log("Feature: %s depends on %.*s, which doesn't exist\n", module.name, (int)name.size(), name.data());
+            ok = false;
+        } else if (!Require(*dependency, patchdef, selected)) {
+            Logging.Log("Feature: %s is off, it needs %s\n", module.name, dependency->module->name);
+            ok = false;
+        }
+    });
+
+    entry.state = ok ? State::Selected : State::Off;
+    if (ok) selected.push_back(&entry);
+    return ok;
+}
+
+static void SelectAll(const rd::config::Patchdef& patchdef, std::vector<Entry*>& selected) {
+    for (Entry& entry : s_Entries) entry.state = State::Unvisited;
+
+    // Required modules only get selected through what depends on them
+    for (Entry& entry : s_Entries)
+        if (entry.module->activation != Activation::Required) Require(entry, patchdef, selected);
+}
+
+void Select() {
+    s_Entries.clear();
+    s_Selected.clear();
+    for (auto modules : Subsystems)
+        for (const Module& module : modules()) s_Entries.push_back({ &module });
+
+    SelectAll(rd::config::config.patchdef, s_Selected);
+
+    std::string names;
+    for (const Entry* entry : s_Selected) {
+        if (!names.empty()) names += ", ";
+        names += entry->module->name;
+    }
+    Logging.Log("Feature: %lu of %lu modules selected: %s\n", s_Selected.size(), s_Entries.size(), names.c_str());
+}
+
+std::vector<std::string> UnusedSignatures() {
+    std::vector<std::string_view> used;
+    for (const Entry* entry : s_Selected)
+        ForEachToken(entry->module->signatures, [&](std::string_view sig) { used.push_back(sig); });
+
+    std::vector<std::string> unused;
+    for (const Entry& entry : s_Entries) {
+        if (entry.state == State::Selected) continue;
+
+        ForEachToken(entry.module->signatures, [&](std::string_view sig) {
+            for (std::string_view other : used)
+                if (other == sig) return;
+            unused.emplace_back(sig);
+        });
+    }
+    return unused;
+}
+
+void Init(const Context& context) {
+    for (Entry* entry : s_Selected) {
+        const Module* module = entry->module;
+        entry->firstHook = rd::hook::HookCount();
+        size_t firstPatch = rd::mem::PatchCount();
+        uint64_t start = trace::Now();
+        {
+            trace::Span span("feature", module->name);
+            module->init(context);
+        }
+        uint64_t micros = (trace::Now() - start) * 1000000 / trace::Frequency();
+        entry->hookCount = rd::hook::HookCount() - entry->firstHook;
+        entry->patchCount = rd::mem::PatchCount() - firstPatch;
+        entry->started = entry->enabled = true;
+
+        Logging.Log("Feature: %s took %lu us, %lu signatures, %lu hooks\n", module->name, micros,
+                    CountTokens(module->signatures), entry->hookCount);
+    }
+}
+
+void Reload(const rd::config::Patchdef& patchdef) {
+    std::vector<Entry*> selected;
+    SelectAll(patchdef, selected);
+
+    auto hooks = rd::hook::InstalledHooks();
+    for (Entry& entry : s_Entries) {
+        bool wanted = entry.state == State::Selected;
+        if (!entry.started) {
+            if (wanted)
+                Logging.Log("Feature: %s wasn't started with the game, restart it to turn it on\n", entry.module->name);
+            continue;
+        }
+        if (wanted == entry.enabled) continue;
+
+        size_t switched = 0;
+        for (const auto& hook : hooks.subspan(entry.firstHook, entry.hookCount))
+            if (rd::hook::SetHookEnabled(hook, wanted)) switched++;
+        entry.enabled = wanted;
+
+        Logging.Log("Feature: %s turned %s, %lu of %lu hooks\n", entry.module->name, wanted ? "on" : "off", switched,
+                    entry.hookCount);
+        if (!wanted && entry.patchCount > 0)
+            Logging.Log("Feature: %s keeps its %lu code patches until the game restarts\n", entry.module->name,
+                        entry.patchCount);
+    }
+}
+
+}  // namespace feature
+}  // namespace rd
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Config.h"
+
+namespace rd {
+namespace feature {
+
+    enum class Activation {
+        Always,    // Runs on every game
+        Option,    // Runs when its patchdef switch is on
+        Required,  // Only runs when a module that runs depends on it
+    };
+
+    struct Context {
+        std::string_view romMount;
+    };
+
+    // A feature with everything it needs, so a disabled one costs nothing at startup.
+    // Lists are space separated: signatures as "Category/Name", dependencies by module name.
+    struct Module {
+        const char* name;
+        Activation activation;
+        bool rd::config::Patchdef::*option;  // Activation::Option only
+        const char* dependsOn;               // Initialized first, a module whose dependency doesn't run doesn't either
+        const char* signatures;              // Signatures only disabled modules list are never scanned
+        void (*init)(const Context& context);
+    };
+
+    // Decides which modules run from the patchdef and in which order, call once the config is loaded
+    void Select();
+
+    // Signatures listed by modules that don't run and by none that do, as "Category/Name"
+    std::vector<std::string> UnusedSignatures();
+
+    // Initializes the selected modules, dependencies first, and logs what each one cost
+    void Init(const Context& context);
+
+    // Decides again from a reloaded patchdef, turning the hooks of modules that were initialized off or back on.
+    // A module that wasn't initialized at startup can't be started any more, and one turned off keeps the code
+    // it overwrote through PatchBatch (widthCheck, fontAlinePtr and the like) until a restart. Both are logged.
+    void Reload(const rd::config::Patchdef& patchdef);
+
+}  // namespace feature
+}  // namespace rd
@@ -1,338 +1,357 @@
+#include <algorithm>
 #include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <string>
 #include <sstream>
 
-#include <frozen/unordered_map.h>
-#include <frozen/string.h>
-
+#include <lib/reloc/reloc.hpp>
 #include <log/logger_mgr.hpp>
 #include <skyline/utils/cpputils.hpp>
 
-#include "Mem.h"
 #include "Hook.h"
 #include "Config.h"
+#include "Pattern.h"
+#include "SigCache.h"
+#include "Signature.h"
+#include "Trace.h"
 
-enum SigExprTokenType {
-    Start,
-    Plus,
-    Minus,
-    Deref,
-    LParen,
-    RParen,
-    Comma,
-    Number,
-    Ptr,
-    End
-};
+using namespace std;
+
+namespace rd {
+namespace hook {
+
+static std::vector<CompiledSignature> s_Signatures;
+static SignatureIndex s_Index;
 
-struct SigExprToken {
-    SigExprTokenType type;
-    uintptr_t value;
+// Results of the single pass over .text done in Init, indexed by CompiledPattern::batchId
+static PatternSet s_Batch;
+
+// What SigScan returned for each of s_Signatures, so it's only logged and evaluated once
+struct ResolvedSignature {
+    uintptr_t address = 0;
+    bool resolved = false;
 };
+static std::vector<ResolvedSignature> s_Resolved;
 
-class SigExprLexer {
-  private:
-    std::string_view input;
-    size_t pos = 0;
-    SigExprToken currentToken;
-    constexpr static auto tokenMapping =
-        frozen::make_unordered_map<char, SigExprTokenType>({
-            { '+', Plus,  }, { '-', Minus  },
-            { '*', Deref  }, { '(', LParen },
-            { ')', RParen }, { ',', Comma  },
-        });
-
-  public:
-    friend class SigExprParser;
-
-    SigExprLexer(std::string_view input) : input(input), currentToken({ Start, 0 }) {}
-
-    SigExprToken getToken() {
-        if (currentToken.type == Start) nextToken();
-        return currentToken;
-    }
+// Hash of the names Init left out, so the scan cache tells the resulting batches apart
+static uint32_t s_DroppedHash = 0;
 
-    void nextToken() {
-        while (pos < input.size() && std::isspace(input[pos])) pos++;
-        
-        decltype(tokenMapping)::const_iterator it;
-
-        if (pos >= input.size()) currentToken = {End, 0};
-        else if ((it = tokenMapping.find(input[pos])) != tokenMapping.end()) { currentToken = { it->second, 0 }; pos++; }
-        else if (std::isdigit(input[pos])) {
-            char *end;
-            currentToken = { Number, (uintptr_t)std::strtoull(input.data() + pos, &end, 0) };
-            pos = end - input.data();
-        } else if (pos + 2 < input.size() && strncasecmp(input.data() + pos, "ptr", 3) == 0) {
-            currentToken = { Ptr, 0 };
-            pos += 3;
-        } else {
-            Logging.Log("Lexing error in '%s' at position %lu: Unexpected character: '%c'", input.data(), pos, input[pos]);
-            std::exit(1);
-        }
-    }
+// Trampoline bytes of each hook installed by the current batch
+struct HookUsage {
+    const char* name;
+    size_t trampolineSize;
 };
+static std::vector<HookUsage> s_HookUsage;
+static std::vector<InstalledHook> s_Installed;
 
-class SigExprParser {
-  private:
-    SigExprLexer lexer;
-    const uintptr_t ptr;
-    constexpr static auto tokenType = 
-        frozen::make_unordered_map<SigExprTokenType, frozen::string>({
-            { Start,  "Start"  }, { Plus,   "Plus"   },
-            { Minus,  "Minus"  }, { Deref,  "Deref"  },
-            { LParen, "LParen" }, { RParen, "RParen" },
-            { Comma,  "Comma"  }, { Number, "Number" },
-            { Ptr,    "Ptr"    }, { End,    "End"    }
-        });
-
-    uintptr_t expression(bool allowComma = true) {
-        uintptr_t result = summand(false, allowComma);
-
-        SigExprToken token = lexer.getToken();
-        while (token.type == Plus || token.type == Minus) {
-            lexer.nextToken();
-
-            result += summand(false, allowComma) * (token.type == Plus ? 1 : -1);
-            token = lexer.getToken();
-        }
-        return result;
-    }
+// Expressions evaluate against the game's own memory
+static bool ReadProcessMemory(uintptr_t address, void* out, size_t size) {
+    memcpy(out, reinterpret_cast<const void*>(address), size);
+    return true;
+}
 
-    uintptr_t summand(bool onlyDereferable, bool allowComma = true) {
-        SigExprToken token = lexer.getToken();
-        lexer.nextToken();
-
-        switch (token.type) {
-            case Deref: {
-                return *(uint64_t*)(summand(true, allowComma));
-            }
-            case LParen: {
-                uintptr_t result = expression();
-                SigExprToken token = lexer.getToken();
-                lexer.nextToken();
-
-                if (token.type == Comma && allowComma) {
-                    ptrdiff_t offset = expression(false);
-                    result = rd::mem::AssemblePointer(result, offset);
-                    token = lexer.getToken();
-                    lexer.nextToken();
-                } 
-                
-                if (token.type != RParen) break;
-                return result;
-            }
-            case Ptr: {
-                return ptr;
-            }
-            case Number: {
-                if (!onlyDereferable) return token.value;
-                break;
-            }
-            default:
-                break;
-        }
+static void LogScanResult(std::string_view pattern, uintptr_t retval) {
+    std::stringstream logstr;
 
-        Logging.Log("Parsing error in '%s': Expected EOL, got %s.\n", lexer.input.data(), tokenType.find(lexer.getToken().type)->second.data());
-        std::exit(1);
-    }
+    logstr << pattern;
 
-  public:
-    SigExprParser(std::string_view input, uintptr_t ptr) : lexer(input), ptr(ptr) {}
+    if (retval != 0) logstr << " found at 0x" << std::hex << std::uppercase << retval << "!\n";
+    else logstr << " not found!\n";
 
-    uintptr_t eval() {
-        uintptr_t result = expression();
-        if (lexer.getToken().type != End) {
-            Logging.Log("Parsing error in '%s': Expected EOL, got %s.\n", lexer.input.data(), tokenType.find(lexer.getToken().type)->second.data());
-            std::exit(1);
-        }
-        return result;
+    Logging.Log(logstr.str());
+}
+
+// Scans for every signature, done in Init unless the running build has precomputed offsets,
+// and otherwise only once something asks for a signature that isn't in them
+static void ScanModule() {
+    static bool scanned = false;
+    if (scanned) return;
+    scanned = true;
+
+    trace::Span span("sigscan", "scan module");
+
+    uintptr_t baseAddress = exl::util::GetMainModuleInfo().m_Text.m_Start;
+    uintptr_t endAddress =  exl::util::GetMainModuleInfo().m_Rodata.m_Start;
+
+    AddToBatch(s_Signatures, s_Batch);
+
+    uint64_t cacheKey = ScanCacheKey(exl::util::GetMainModuleInfo(), s_DroppedHash);
+    bool cached;
+    {
+        trace::Span load("sigscan", "load cache");
+        cached = LoadScanCache(cacheKey, s_Batch, baseAddress);
     }
-};
+    if (!cached) {
+        s_Batch.Scan((unsigned char*)baseAddress, (unsigned char*)endAddress, baseAddress, PatternSet::MaxWorkers);
+        Logging.Log("SigScan: resolved %lu patterns in a single pass\n", s_Batch.Size());
 
-using namespace std;
+        trace::Span save("sigscan", "save cache");
+        SaveScanCache(cacheKey, s_Batch, baseAddress);
+    }
 
-namespace rd {
-namespace hook {
+    // Scoped signatures only look at their own few bytes and xrefs take a single pass, so they aren't cached
+    const exl::util::ModuleInfo& module = exl::util::GetMainModuleInfo();
+    ModuleLayout layout = {
+        .memory = (const uint8_t*)module.m_Total.m_Start,
+        .base = module.m_Total.m_Start,
+        .textStart = module.m_Text.m_Start,
+        .textEnd = module.m_Text.GetEnd(),
+        .rodataStart = module.m_Rodata.m_Start,
+        .rodataEnd = module.m_Rodata.GetEnd(),
+        .dataStart = module.m_Data.m_Start,
+        .dataEnd = module.m_Data.GetEnd(),
+    };
+
+    std::vector<std::string> errors;
+    trace::Span deferred("sigscan", "scoped and xref signatures");
+    ResolveDeferred(s_Signatures, s_Batch, layout, ReadProcessMemory, errors);
+    for (const std::string& error : errors) Logging.Log(error);
+}
 
-struct PatternByte {
-    struct PatternNibble {
-        unsigned char data;
-        bool wildcard;
-    } nibble[2];
-};
+// The offset symbol has in a known build's table, from the tables generated out of offsets/
+static bool FindPrecomputed(const char* symbol, int length, uintptr_t& offset, exl::util::ModuleIndex& module) {
+    auto entries = exl::reloc::GetLookupTable().GetEntries();
+    if (entries.empty() || length < 0) return false;
 
-static string FormatPattern(string patterntext) {
-    string result;
-    int len = patterntext.length();
-    for (int i = 0; i < len; i++)
-        if (patterntext[i] == '?' || isxdigit(patterntext[i]))
-        result += toupper(patterntext[i]);
-    return result;
+    auto hash = exl::util::Murmur3::Compute(std::string_view(symbol, length));
+    auto entry = std::lower_bound(entries.begin(), entries.end(), hash);
+    if (entry == entries.end() || entry->m_SymbolHash != hash) return false;
+
+    offset = entry->m_Offset;
+    module = entry->m_ModuleIndex;
+    return true;
 }
 
-static int HexChToInt(char ch) {
-    if (ch >= '0' && ch <= '9')
-        return ch - '0';
-    else if (ch >= 'A' && ch <= 'F')
-        return ch - 'A' + 10;
-    else if (ch >= 'a' && ch <= 'f')
-        return ch - 'a' + 10;
-    return 0;
+// Where a signature resolves to in a known build, or 0
+static uintptr_t FindPrecomputed(const CompiledSignature& sig) {
+    char symbol[256];
+    int length = snprintf(symbol, sizeof(symbol), "%.*s/%.*s", (int)sig.category.size(), sig.category.data(),
+                          (int)sig.name.size(), sig.name.data());
+    if ((size_t)length >= sizeof(symbol)) return 0;
+
+    uintptr_t offset;
+    exl::util::ModuleIndex module;
+    if (!FindPrecomputed(symbol, length, offset, module)) return 0;
+    return exl::util::GetModuleInfo(module).m_Total.m_Start + offset;
+}
+
+// Every match of one of a signature's patterns in a known build, false when the table doesn't list them
+static bool FindPrecomputedMatches(const CompiledSignature& sig, size_t pattern, std::vector<uintptr_t>& matches) {
+    char symbol[256];
+    uintptr_t count;
+    exl::util::ModuleIndex module;
+    int length = PrecomputedMatchSymbol(symbol, sizeof(symbol), sig, pattern);
+    if ((size_t)length >= sizeof(symbol) || !FindPrecomputed(symbol, length, count, module)) return false;
+
+    matches.clear();
+    for (size_t i = 0; i < count; i++) {
+        uintptr_t offset;
+        length = PrecomputedMatchSymbol(symbol, sizeof(symbol), sig, pattern, i);
+        if ((size_t)length >= sizeof(symbol) || !FindPrecomputed(symbol, length, offset, module)) return false;
+        matches.push_back(exl::util::GetModuleInfo(module).m_Total.m_Start + offset);
+    }
+    return true;
 }
 
-static bool TransformPattern(string patterntext, vector<PatternByte>& pattern) {
-    pattern.clear();
-    patterntext = FormatPattern(patterntext);
-    int len = patterntext.length();
-    if (!len) return false;
+// Drops the unused signatures nothing that stays depends on, returns how many went
+static size_t DropUnused(std::span<const std::string> unused) {
+    std::vector<bool> drop(s_Signatures.size(), false);
+    for (const std::string& name : unused) {
+        size_t slash = name.find('/');
+        if (slash == std::string::npos) continue;
 
-    if (len % 2) {                              // not a multiple of 2
-        patterntext += '?';
-        len++;
+        const CompiledSignature* sig = FindSignature(s_Signatures, std::string_view(name).substr(0, slash),
+                                                     std::string_view(name).substr(slash + 1));
+        if (sig) drop[sig - s_Signatures.data()] = true;
     }
 
-    PatternByte newByte;
-    for (int i = 0, j = 0; i < len; i++) {
-        if (patterntext[i] == '?') {            // wildcard
-            newByte.nibble[j].wildcard = true;  // match anything
-        } else {                                // hex
-            newByte.nibble[j].wildcard = false;
-            newByte.nibble[j].data = HexChToInt(patterntext[i]) & 0xF;
+    // Dependencies can chain, keep going until nothing else is kept
+    auto keep = [&](std::string_view category, std::string_view name) {
+        const CompiledSignature* sig = name.empty() ? nullptr : FindSignature(s_Signatures, category, name);
+        if (!sig || !drop[sig - s_Signatures.data()]) return false;
+        drop[sig - s_Signatures.data()] = false;
+        return true;
+    };
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (size_t i = 0; i < s_Signatures.size(); i++) {
+            if (drop[i]) continue;
+            const CompiledSignature& sig = s_Signatures[i];
+            changed |= keep(sig.scope.nearCategory, sig.scope.nearName);
+            changed |= keep(sig.xref.category, sig.xref.name);
         }
+    }
 
-        j++;
-
-        if (j == 2) {  // two nibbles = one byte
-            j = 0;
-            pattern.push_back(newByte);
+    // Stays sorted, FindSignature relies on it
+    size_t kept = 0;
+    for (size_t i = 0; i < s_Signatures.size(); i++) {
+        if (drop[i]) {
+            s_DroppedHash = exl::util::Murmur3::Compute(s_Signatures[i].category, s_DroppedHash);
+            s_DroppedHash = exl::util::Murmur3::Compute(s_Signatures[i].name, s_DroppedHash);
+            continue;
         }
+        s_Signatures[kept++] = std::move(s_Signatures[i]);
     }
-    return true;
+
+    size_t dropped = s_Signatures.size() - kept;
+    s_Signatures.erase(s_Signatures.begin() + kept, s_Signatures.end());
+    return dropped;
 }
 
-static bool MatchByte(const unsigned char byte, const PatternByte& pbyte) {
-    int matched = 0;
+void Init(std::span<const std::string> unused) {
+    s_Signatures = std::move(rd::config::config.signatures);
 
-    unsigned char n1 = (byte >> 4) & 0xF;
-    if (pbyte.nibble[0].wildcard)
-        matched++;
-    else if (pbyte.nibble[0].data == n1)
-        matched++;
+    if (size_t dropped = DropUnused(unused))
+        Logging.Log("SigScan: skipping %lu signatures only disabled features use\n", dropped);
+    s_Index.Build(s_Signatures);
 
-    unsigned char n2 = byte & 0xF;
-    if (pbyte.nibble[1].wildcard)
-        matched++;
-    else if (pbyte.nibble[1].data == n2)
-        matched++;
+    if (exl::reloc::GetLookupTable().GetEntries().empty()) ScanModule();
+    else Logging.Log("SigScan: known build, using %lu precomputed offsets\n", exl::reloc::GetLookupTable().GetEntries().size());
 
-    return (matched == 2);
+    ResolveAll();
 }
 
-uintptr_t FindPattern(const unsigned char* dataStart,
-                      const unsigned char* dataEnd, std::string_view pszPattern,
-                      uintptr_t baseAddress, size_t offset, int occurrence) {
-    // Build vectored pattern..
-    vector<PatternByte> patterndata;
-    if (!TransformPattern(pszPattern.data(), patterndata)) return 0;
+void ResolveAll() {
+    s_Resolved.assign(s_Signatures.size(), {});
 
-    // The result count for multiple results..
-    int resultCount = 0;
-    const unsigned char* scanStart = dataStart;
+    for (const CompiledSignature& sig : s_Signatures)
+        if (!sig.isArray) SigScan(SigKey(sig.category, sig.name));
+}
 
-    while (true) {
-        // Search for the pattern..
-        const unsigned char* ret = search(scanStart, dataEnd, patterndata.begin(),
-                                          patterndata.end(), MatchByte);
+// Collects every match in a single pass over .text, or the signature's scope,
+// for patterns the batch didn't keep all matches of
+static std::vector<uintptr_t> SigScanAll(const CompiledSignature& sig, const CompiledPattern& compiled) {
+    uintptr_t baseAddress = exl::util::GetMainModuleInfo().m_Text.m_Start;
+    uintptr_t endAddress =  exl::util::GetMainModuleInfo().m_Rodata.m_Start;
 
-        // Did we find a match..
-        if (ret == dataEnd) break;
+    if (sig.Deferred()) {
+        baseAddress = sig.scanStart;
+        endAddress = sig.scanEnd;
+    }
 
-        // If we hit the usage count, return the result..
-        if (occurrence == 0 || resultCount == occurrence)
-            return baseAddress + distance(dataStart, ret) + offset;
+    auto ret = std::vector<uintptr_t>();
 
-        // Increment the found count and scan again..
-        resultCount++;
-        scanStart = ++ret;
+    PatternCursor cursor(compiled.pattern.view, (unsigned char*)baseAddress, (unsigned char*)endAddress);
+    while (const uint8_t* match = cursor.Next()) {
+        ret.push_back((uintptr_t)match);
+        LogScanResult(compiled.text, (uintptr_t)match);
     }
 
-    return 0;
+    if (ret.empty()) LogScanResult(compiled.text, 0);
+    return ret;
 }
 
-uintptr_t SigScanRaw(std::string_view pattern, size_t offset, int occurrence) {
-    std::stringstream logstr;
-
-    logstr << pattern;
+static const CompiledSignature* FindSignatureOrLog(const SigKey& key, bool isArray) {
+    const CompiledSignature* sig = s_Index.Find(key);
+    if (sig == nullptr || sig->isArray != isArray || (sig->patterns.empty() && sig->xref.kind == SigXRef::Kind::None)) {
+        Logging.Log("Signature for %.*s is missing!\n", (int)key.name.size(), key.name.data());
+        return nullptr;
+    }
 
-    uintptr_t baseAddress = exl::util::GetMainModuleInfo().m_Text.m_Start;
-    uintptr_t endAddress =  exl::util::GetMainModuleInfo().m_Rodata.m_Start;
-    
-    uintptr_t retval = FindPattern((unsigned char*)baseAddress,
-                                   (unsigned char*)endAddress,
-                                   pattern, baseAddress, offset,
-                                   occurrence);
+    Logging.Log("SigScan: looking for %.*s/%.*s...\n", (int)key.category.size(), key.category.data(),
+                (int)key.name.size(), key.name.data());
+    return sig;
+}
 
-    if (retval != 0) logstr << " found at 0x" << std::hex << std::uppercase << retval << "!\n";
-    else logstr << " not found!\n";
+static uintptr_t Resolve(const CompiledSignature* sig) {
+    uintptr_t raw = ResolveMatch(*sig, s_Batch);
+    LogScanResult(sig->patterns.empty() ? sig->name : sig->patterns.front().text, raw);
 
-    Logging.Log(logstr.str());
-    return retval;
-}
+    if (sig->expr.Empty()) return raw;
+    if (raw == 0) return raw;
 
-uintptr_t SigScan(const char* category, const char* sigName) {
-    if (!rd::config::config["gamedef"]["signatures"][category].has(sigName)){
-        Logging.Log("Signature for %s is missing!\n", sigName);
+    uintptr_t result;
+    std::string error;
+    if (!sig->expr.Eval(raw, ReadProcessMemory, result, error)) {
+        Logging.Log(error);
         return 0;
     }
+    return result;
+}
 
-    Logging.Log("SigScan: looking for %s/%s...\n", category, sigName);
+bool HasSignature(const SigKey& key) {
+    return s_Index.Find(key) != nullptr;
+}
 
-    rd::config::JsonWrapper sig = rd::config::config["gamedef"]["signatures"][category][sigName];
-    uintptr_t raw = SigScanRaw(sig["pattern"].get<std::string_view>(), sig["offset"].get<size_t>(), sig["occurrence"].get<int>());
-    
-    if (!sig.has("expr")) return raw;
-    if (raw == 0) return raw;
-    return SigExprParser(sig["expr"].get<std::string_view>(), raw).eval();
+uintptr_t SigScan(const SigKey& key) {
+    const CompiledSignature* sig = s_Index.Find(key);
+    ResolvedSignature* resolved = sig && !s_Resolved.empty() ? &s_Resolved[sig - s_Signatures.data()] : nullptr;
+    if (resolved && resolved->resolved) return resolved->address;
+
+    sig = FindSignatureOrLog(key, false);
+    if (sig == nullptr) return 0;
+
+    trace::Span span("sigscan", sig->name.data());
+
+    uintptr_t address = FindPrecomputed(*sig);
+    if (address != 0) {
+        LogScanResult(sig->name, address);
+    } else {
+        ScanModule();
+        address = Resolve(sig);
+    }
+    if (resolved) *resolved = { address, true };
+    return address;
 }
 
-std::vector<uintptr_t> SigScanExhaust(const char *category, const char *sigName) {
+std::vector<uintptr_t> SigScanExhaust(const SigKey& key) {
     auto ret = std::vector<uintptr_t>();
 
-    if (!rd::config::config["gamedef"]["signatures"][category].has(sigName)){
-        Logging.Log("Signature for %s is missing!\n", sigName);
+    const CompiledSignature* sig = FindSignatureOrLog(key, false);
+    if (sig == nullptr) return ret;
+
+    if (FindPrecomputedMatches(*sig, 0, ret)) {
+        for (uintptr_t match : ret) LogScanResult(sig->name, match);
+        return ret;
     }
 
-    Logging.Log("SigScan: looking for %s/%s...\n", category, sigName);
+    ScanModule();
+    if (sig->xref.kind == SigXRef::Kind::To) {
+        for (uintptr_t match : sig->deferredMatches) LogScanResult(sig->name, match);
+        return sig->deferredMatches;
+    }
+    if (sig->xref.kind == SigXRef::Kind::From) {
+        if (uintptr_t match = ResolveMatch(*sig, s_Batch)) ret.push_back(match - sig->offset);
+        return ret;
+    }
 
-    rd::config::JsonWrapper sig = rd::config::config["gamedef"]["signatures"][category][sigName];
+    // The batch only keeps as many matches as the occurrence needs
+    const CompiledPattern& compiled = sig->patterns.front();
+    if (compiled.batchId == SIZE_MAX || s_Batch.Count(compiled.batchId) != s_Batch.Matches(compiled.batchId).size())
+        return SigScanAll(*sig, compiled);
 
-    uintptr_t raw;
-    int occur = 0;
-    while ((raw = SigScanRaw(sig["pattern"].get<std::string_view>(), 0, occur++)) != 0) {
-        ret.push_back(raw);
+    for (uintptr_t match : s_Batch.Matches(compiled.batchId)) {
+        LogScanResult(compiled.text, match);
+        ret.push_back(match);
     }
-    
     return ret;
 }
 
 
-std::vector<uintptr_t> SigScanArray(const char *category, const char *sigName, bool exhaust) {
+std::vector<uintptr_t> SigScanArray(const SigKey& key, bool exhaust) {
     auto ret = std::vector<uintptr_t>();
 
-    if (!rd::config::config["gamedef"]["signatures"][category].has(sigName)){
-        Logging.Log("Signature for %s is missing!\n", sigName);
-    }
+    const CompiledSignature* sig = FindSignatureOrLog(key, true);
+    if (sig == nullptr) return ret;
 
-    Logging.Log("SigScan: looking for %s/%s...\n", category, sigName);
+    std::vector<uintptr_t> precomputed;
+    for (size_t i = 0; i < sig->patterns.size(); i++) {
+        const CompiledPattern& compiled = sig->patterns[i];
 
-    rd::config::JsonWrapper sig = rd::config::config["gamedef"]["signatures"][category][sigName];
+        std::span<const uintptr_t> matches;
+        if (FindPrecomputedMatches(*sig, i, precomputed)) {
+            matches = precomputed;
+        } else {
+            ScanModule();
+            matches = s_Batch.Matches(compiled.batchId);
+        }
+        if (matches.empty()) LogScanResult(compiled.text, 0);
 
-    for (auto pattern : sig["patterns"].get<std::vector<string_view>>()) {
-        uintptr_t raw;
-        int occur = 0;
-        while ((raw = SigScanRaw(pattern, 0, occur++)) != 0) {
-            ret.push_back(raw);
+        for (uintptr_t match : matches) {
+            LogScanResult(compiled.text, match);
+            ret.push_back(match);
             if (!exhaust) break;
         }
     }
@@ -340,5 +359,54 @@ std::vector<uintptr_t> SigScanArray(const char *category, const char *sigName, b
     return ret;
 }
 
+HookBatch::HookBatch() {
+    s_HookUsage.clear();
+    exl::hook::nx64::BeginBatch();
+}
+
+HookBatch::~HookBatch() {
+    size_t patched;
+    {
+        trace::Span span("hook", "commit batch");
+        patched = exl::hook::nx64::EndBatch();
+    }
+
+    size_t slotSize = exl::hook::nx64::GetTrampolineSlotSize();
+    size_t written = 0;
+    for (const HookUsage& hook : s_HookUsage) {
+        Logging.Log("Hook: %s uses %lu of its %lu trampoline bytes\n", hook.name, hook.trampolineSize, slotSize);
+        written += hook.trampolineSize;
+    }
+
+    size_t used = exl::hook::nx64::GetTrampolinesUsed();
+    Logging.Log("Hook: installed %lu hooks at once, %lu bytes of trampolines written, "
+                "%lu of %lu slots taken (0x%lx of 0x%lx JIT bytes)\n",
+                patched, written, used, exl::hook::nx64::GetTrampolineCapacity(), used * slotSize,
+                exl::setting::JitSize);
+    s_HookUsage.clear();
+}
+
+void RecordHook(const char* name, uintptr_t address) {
+    s_HookUsage.push_back({ name, exl::hook::nx64::GetLastTrampolineSize() });
+    s_Installed.push_back({ name, address });
+}
+
+size_t HookCount() {
+    return s_Installed.size();
+}
+
+std::span<const InstalledHook> InstalledHooks() {
+    return s_Installed;
+}
+
+bool SetHookEnabled(const InstalledHook& hook, bool enabled) {
+    trace::Span span("hook", hook.name);
+    if (exl::hook::nx64::SetEnabled(hook.address, enabled)) return true;
+
+    Logging.Log("Hook: %s is more than a branch, it can't be turned %s while the game runs\n", hook.name,
+                enabled ? "on" : "off");
+    return false;
+}
+
 }  // namespace hook
-}  // namespace rd
\ No newline at end of file
+}  // namespace rd
@@ -1,33 +1,105 @@
 #pragma once
 
+#include <span>
+#include <string>
+
 #include <lib.hpp>
 #include <lib/hook/trampoline.hpp>
 
 #include "Config.h"
+#include "Pattern.h"
+#include "Signature.h"
+#include "Trace.h"
 
 #define DECLARE_HOOK(name, ret, ...)                                                    \
     HOOK_DEFINE_TRAMPOLINE(name) { static ret Callback(__VA_ARGS__); };
 
+// Game functions we only call, Orig is resolved from the signature and the function itself is left alone
+#define DECLARE_FUNC(name, ret, ...)                                                    \
+    struct name {                                                                       \
+        static inline ret (*Orig)(__VA_ARGS__) = nullptr;                               \
+        static ret Callback(__VA_ARGS__);                                               \
+    };
+
 #define HOOK_FUNC(category, name)                                                       \
     [&]{                                                                                \
-        if (!rd::config::config["gamedef"]["signatures"][#category].has(#name)) return; \
-        name::InstallAtPtr(rd::hook::SigScan(#category, #name));                        \
+        static constexpr auto key = rd::hook::MakeSigKey(#category, #name);             \
+        if (!rd::hook::HasSignature(key)) return;                                       \
+        uintptr_t address = rd::hook::SigScan(key);                                     \
+        if (address == 0) return;                                                       \
+        rd::trace::Span span("hook", #name);                                            \
+        name::InstallAtPtr(address);                                                    \
+        rd::hook::RecordHook(#name, address);                                           \
+    }()
+
+#define BIND_FUNC(category, name)                                                       \
+    [&]{                                                                                \
+        static constexpr auto key = rd::hook::MakeSigKey(#category, #name);             \
+        if (!rd::hook::HasSignature(key)) return;                                       \
+        uintptr_t address = rd::hook::SigScan(key);                                     \
+        if (address == 0) {                                                             \
+            Logging.Log("Failed to bind " #category "/" #name "\n");                    \
+            return;                                                                     \
+        }                                                                               \
+        name::Orig = reinterpret_cast<decltype(name::Orig)>(address);                   \
     }()
 
 #define HOOK_VAR(category, name)                                                        \
-    name = reinterpret_cast<decltype(name)>(rd::hook::SigScan(#category, #name));
+    name = reinterpret_cast<decltype(name)>(rd::hook::SigScan(rd::hook::MakeSigKey(#category, #name)));
+
+// Whether the gamedef has a signature, with its key hashed at compile time
+#define HAS_SIG(category, name) rd::hook::HasSignature(rd::hook::MakeSigKey(#category, #name))
 
 namespace rd {
 namespace hook {
 
-    uintptr_t FindPattern(const uint8_t* dataStart, const uint8_t* dataEnd, const char* pszPattern,
-                          uintptr_t baseAddress, size_t offset, int occurrence);
+    // Resolves every pattern in the gamedef with one pass over .text, or from the precomputed offsets
+    // of a known build, SigScan* then read the results. Signatures in unused ("Category/Name") are left out,
+    // unless one that stays is scoped near them or refers to them.
+    void Init(std::span<const std::string> unused = {});
+
+    // Resolves every signature once, SigScan then returns the same addresses without logging them again
+    void ResolveAll();
+
+    // Whether the gamedef has the signature and it compiled
+    bool HasSignature(const SigKey& key);
+
+    // Resolved once and remembered, later calls for the same signature are a lookup.
+    // Keys built from literals, SigScan({ "game", "Name" }), are hashed at compile time.
+    uintptr_t SigScan(const SigKey& key);
+
+    std::vector<uintptr_t> SigScanExhaust(const SigKey& key);
+
+    std::vector<uintptr_t> SigScanArray(const SigKey& key, bool exhaust = false);
+
+    // Hooks installed while one is alive only get their trampolines written, they all go live when it ends
+    // with a single JIT flush and one mapping for each cluster of targets. The JIT use of each is logged then.
+    class HookBatch {
+      public:
+        HookBatch();
+        ~HookBatch();
+
+        HookBatch(const HookBatch&) = delete;
+        HookBatch& operator=(const HookBatch&) = delete;
+    };
+
+    struct InstalledHook {
+        const char* name;
+        uintptr_t address;
+    };
+
+    // Notes the hook HOOK_FUNC just installed at address, and how much of the JIT it took up
+    void RecordHook(const char* name, uintptr_t address);
 
-    uintptr_t SigScan(const char* category, const char* sigName);
+    // Hooks HOOK_FUNC installed so far
+    size_t HookCount();
 
-    std::vector<uintptr_t> SigScanExhaust(const char* category, const char* sigName);
+    // Every hook HOOK_FUNC installed, in order
+    std::span<const InstalledHook> InstalledHooks();
 
-    std::vector<uintptr_t> SigScanArray(const char* category, const char* sigName, bool exhaust = false);
+    // Puts the game's own code back at a hook while the game runs, or the hook again.
+    // Hooks patched in with more than a branch are logged and left as they are.
+    bool SetHookEnabled(const InstalledHook& hook, bool enabled);
 
 }  // namespace hook
 }  // namespace rd
\ No newline at end of file
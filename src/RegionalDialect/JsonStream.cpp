@@ -0,0 +1,312 @@
+#include <cstdlib>
+
+#include "JsonStream.h"
+
+using namespace std;
+
+namespace rd {
+namespace config {
+
+static bool IsSpace(char ch) {
+    return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r';
+}
+
+static bool IsNumberChar(char ch) {
+    return (ch >= '0' && ch <= '9') || ch == '-' || ch == '+' || ch == '.' || ch == 'e' || ch == 'E';
+}
+
+static bool IsLetter(char ch) {
+    return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z');
+}
+
+static int HexDigit(char ch) {
+    if (ch >= '0' && ch <= '9') return ch - '0';
+    if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+    if (ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
+    return -1;
+}
+
+JsonStream::~JsonStream() {
+    cJSON_Delete(root);
+}
+
+bool JsonStream::Feed(string_view chunk, string& error) {
+    for (char ch : chunk) {
+        if (!Step(ch)) {
+            error = failure;
+            return false;
+        }
+        offset++;
+    }
+    return true;
+}
+
+cJSON* JsonStream::Finish(string& error) {
+    // A number or literal only ends with what follows it, which the root one doesn't have
+    bool ok = true;
+    if (lex == Lex::Number) ok = EndNumber();
+    else if (lex == Lex::Literal) ok = EndLiteral();
+    else if (lex == Lex::String) ok = Fail("The document ends inside a string");
+    lex = Lex::None;
+
+    if (ok && expect != Expect::Done) ok = Fail("The document ends early");
+    if (!ok) {
+        error = failure;
+        return nullptr;
+    }
+
+    cJSON* ret = root;
+    root = nullptr;
+    return ret;
+}
+
+bool JsonStream::Fail(string_view what) {
+    failure = string(what) + " at byte " + to_string(offset) + ".\n";
+    return false;
+}
+
+bool JsonStream::Keeping() const {
+    if (stack.empty()) return true;
+
+    const Frame& parent = stack.back();
+    if (parent.node == nullptr) return false;
+    if (stack.size() > 1 || !parent.isObject) return true;
+
+    for (string_view name : keep)
+        if (name == key) return true;
+    return false;
+}
+
+bool JsonStream::Attach(cJSON* item) {
+    if (item == nullptr) return Fail("Out of memory");
+
+    if (stack.empty()) {
+        root = item;
+        return true;
+    }
+
+    cJSON* parent = stack.back().node;
+    bool added = stack.back().isObject ? cJSON_AddItemToObject(parent, key.c_str(), item)
+                                       : cJSON_AddItemToArray(parent, item);
+    if (added) return true;
+
+    cJSON_Delete(item);
+    return Fail("Out of memory");
+}
+
+bool JsonStream::Step(char ch) {
+    switch (lex) {
+        case Lex::String:
+            return StringChar(ch);
+        case Lex::Number:
+            if (IsNumberChar(ch)) {
+                token += ch;
+                return true;
+            }
+            lex = Lex::None;
+            if (!EndNumber()) return false;
+            break;
+        case Lex::Literal:
+            if (IsLetter(ch)) {
+                token += ch;
+                return true;
+            }
+            lex = Lex::None;
+            if (!EndLiteral()) return false;
+            break;
+        case Lex::None:
+            break;
+    }
+
+    if (IsSpace(ch)) return true;
+
+    switch (expect) {
+        case Expect::FirstValueOrEnd:
+            if (ch == ']') return Close();
+            [[fallthrough]];
+        case Expect::Value:
+            return BeginValue(ch);
+        case Expect::FirstKeyOrEnd:
+            if (ch == '}') return Close();
+            [[fallthrough]];
+        case Expect::Key:
+            if (ch != '"') return Fail("Expected a key");
+            lex = Lex::String;
+            tokenIsKey = true;
+            storeToken = stack.back().node != nullptr;
+            token.clear();
+            return true;
+        case Expect::Colon:
+            if (ch != ':') return Fail("Expected ':'");
+            expect = Expect::Value;
+            return true;
+        case Expect::CommaOrEnd:
+            if (ch == ',') {
+                expect = stack.back().isObject ? Expect::Key : Expect::Value;
+                return true;
+            }
+            if (ch == (stack.back().isObject ? '}' : ']')) return Close();
+            return Fail("Expected ',' or the end of the container");
+        case Expect::Done:
+            return Fail("Unexpected text after the document");
+    }
+    return false;
+}
+
+bool JsonStream::BeginValue(char ch) {
+    if (ch == '{' || ch == '[') return Open(ch == '{');
+
+    token.clear();
+    if (ch == '"') {
+        lex = Lex::String;
+        tokenIsKey = false;
+        storeToken = Keeping();
+    } else if (ch == '-' || (ch >= '0' && ch <= '9')) {
+        lex = Lex::Number;
+        token += ch;
+    } else if (IsLetter(ch)) {
+        lex = Lex::Literal;
+        token += ch;
+    } else {
+        return Fail(string("Unexpected '") + ch + "'");
+    }
+    return true;
+}
+
+bool JsonStream::Open(bool isObject) {
+    if (stack.size() >= CJSON_NESTING_LIMIT) return Fail("Nested too deep");
+
+    cJSON* node = nullptr;
+    if (Keeping()) {
+        node = isObject ? cJSON_CreateObject() : cJSON_CreateArray();
+        if (!Attach(node)) return false;
+    }
+
+    stack.push_back({ node, isObject });
+    expect = isObject ? Expect::FirstKeyOrEnd : Expect::FirstValueOrEnd;
+    return true;
+}
+
+bool JsonStream::Close() {
+    stack.pop_back();
+    EndValue();
+    return true;
+}
+
+bool JsonStream::StringChar(char ch) {
+    if (unicodeDigits > 0) {
+        int digit = HexDigit(ch);
+        if (digit < 0) return Fail("Malformed \\u escape");
+        codepoint = codepoint << 4 | digit;
+        return --unicodeDigits > 0 || EndEscape();
+    }
+
+    // The high half of a surrogate pair must be followed by the low half
+    if (highSurrogate != 0 && !(escape ? ch == 'u' : ch == '\\')) return Fail("Unpaired surrogate");
+
+    if (escape) {
+        escape = false;
+        switch (ch) {
+            case '"': case '\\': case '/': Put(ch); break;
+            case 'b': Put('\b'); break;
+            case 'f': Put('\f'); break;
+            case 'n': Put('\n'); break;
+            case 'r': Put('\r'); break;
+            case 't': Put('\t'); break;
+            case 'u':
+                unicodeDigits = 4;
+                codepoint = 0;
+                break;
+            default:
+                return Fail("Unknown escape");
+        }
+        return true;
+    }
+
+    if (ch == '\\') {
+        escape = true;
+        return true;
+    }
+    if (ch == '"') {
+        lex = Lex::None;
+        return EndString();
+    }
+
+    Put(ch);
+    return true;
+}
+
+bool JsonStream::EndEscape() {
+    if (highSurrogate != 0) {
+        if (codepoint < 0xDC00 || codepoint > 0xDFFF) return Fail("Unpaired surrogate");
+        PutCodepoint(0x10000 + ((highSurrogate - 0xD800) << 10) + (codepoint - 0xDC00));
+        highSurrogate = 0;
+    } else if (codepoint >= 0xD800 && codepoint <= 0xDBFF) {
+        highSurrogate = codepoint;
+    } else if (codepoint >= 0xDC00 && codepoint <= 0xDFFF) {
+        return Fail("Unpaired surrogate");
+    } else {
+        PutCodepoint(codepoint);
+    }
+    return true;
+}
+
+void JsonStream::Put(char ch) {
+    if (storeToken) token += ch;
+}
+
+void JsonStream::PutCodepoint(uint32_t codepoint) {
+    if (codepoint < 0x80) {
+        Put(codepoint);
+    } else if (codepoint < 0x800) {
+        Put(0xC0 | codepoint >> 6);
+        Put(0x80 | (codepoint & 0x3F));
+    } else if (codepoint < 0x10000) {
+        Put(0xE0 | codepoint >> 12);
+        Put(0x80 | (codepoint >> 6 & 0x3F));
+        Put(0x80 | (codepoint & 0x3F));
+    } else {
+        Put(0xF0 | codepoint >> 18);
+        Put(0x80 | (codepoint >> 12 & 0x3F));
+        Put(0x80 | (codepoint >> 6 & 0x3F));
+        Put(0x80 | (codepoint & 0x3F));
+    }
+}
+
+bool JsonStream::EndString() {
+    if (tokenIsKey) {
+        // Only a kept object needs its keys, skipped ones weren't stored
+        key = storeToken ? std::move(token) : string();
+        expect = Expect::Colon;
+        return true;
+    }
+
+    if (storeToken && !Attach(cJSON_CreateString(token.c_str()))) return false;
+    EndValue();
+    return true;
+}
+
+bool JsonStream::EndNumber() {
+    char* end;
+    double value = strtod(token.c_str(), &end);
+    if (token.empty() || end != token.c_str() + token.size()) return Fail("Malformed number");
+
+    if (Keeping() && !Attach(cJSON_CreateNumber(value))) return false;
+    EndValue();
+    return true;
+}
+
+bool JsonStream::EndLiteral() {
+    cJSON* (*create)() = nullptr;
+    if (token == "true") create = cJSON_CreateTrue;
+    else if (token == "false") create = cJSON_CreateFalse;
+    else if (token == "null") create = cJSON_CreateNull;
+    else return Fail("Unknown literal '" + token + "'");
+
+    if (Keeping() && !Attach(create())) return false;
+    EndValue();
+    return true;
+}
+
+}  // namespace config
+}  // namespace rd
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <cJSON/cJSON.h>
+
+namespace rd {
+namespace config {
+
+    // Push parser for JSON that arrives a chunk at a time, such as a config file read in pieces.
+    // Only the root object's members listed in keep become cJSON nodes, everything else is checked and dropped
+    // as it's read, so neither the file nor the sections nobody reads are ever held in memory.
+    class JsonStream {
+      public:
+        // keep must outlive the stream
+        explicit JsonStream(std::span<const std::string_view> keep) : keep(keep) {}
+        ~JsonStream();
+
+        JsonStream(const JsonStream&) = delete;
+        JsonStream& operator=(const JsonStream&) = delete;
+
+        // Chunks can split a token anywhere. Fails with a message in error on malformed JSON.
+        bool Feed(std::string_view chunk, std::string& error);
+
+        // The tree once the whole document has been fed, which the caller then owns.
+        // nullptr with a message in error when the document isn't complete.
+        cJSON* Finish(std::string& error);
+
+      private:
+        enum class Lex { None, String, Number, Literal };
+        enum class Expect { Value, FirstValueOrEnd, FirstKeyOrEnd, Key, Colon, CommaOrEnd, Done };
+
+        struct Frame {
+            cJSON* node;  // nullptr for a container that's skipped
+            bool isObject;
+        };
+
+        bool Step(char ch);
+        bool BeginValue(char ch);
+        bool Open(bool isObject);
+        bool Close();
+        bool StringChar(char ch);
+        bool EndString();
+        bool EndNumber();
+        bool EndLiteral();
+        bool EndEscape();
+        bool Attach(cJSON* item);
+        void EndValue() { expect = stack.empty() ? Expect::Done : Expect::CommaOrEnd; }
+
+        // Whether the value starting now becomes a node
+        bool Keeping() const;
+        void Put(char ch);
+        void PutCodepoint(uint32_t codepoint);
+        bool Fail(std::string_view what);
+
+        std::span<const std::string_view> keep;
+        cJSON* root = nullptr;
+        std::vector<Frame> stack;
+        Expect expect = Expect::Value;
+
+        Lex lex = Lex::None;
+        std::string token;  // The string, number or literal being read, strings only when they're kept
+        bool storeToken = false;
+        bool tokenIsKey = false;
+        std::string key;    // Of the member whose value comes next, when its object is kept
+
+        bool escape = false;
+        int unicodeDigits = 0;  // Of a \u escape still to come
+        uint32_t codepoint = 0;
+        uint32_t highSurrogate = 0;  // Waiting for the low half of a pair when not 0
+
+        size_t offset = 0;  // Bytes fed so far, for errors
+        std::string failure;
+    };
+
+}  // namespace config
+}  // namespace rd
@@ -1,5 +1,8 @@
+#include <algorithm>
+
 #include <log/logger_mgr.hpp>
 
+#include "Decode.h"
 #include "Mem.h"
 
 extern uintptr_t codeCaves;
@@ -7,33 +10,72 @@ extern uintptr_t codeCaves;
 namespace rd {
 namespace mem {
 
-void Trampoline(uintptr_t address, uintptr_t target, reg::Register reg) {    
+void PatchBatch::Add(uintptr_t address, const void *value, size_t size) {
+    writes.push_back({ address, data.size(), size });
+    data.insert(data.end(), (const uint8_t*)value, (const uint8_t*)value + size);
+}
+
+static size_t s_PatchCount = 0;
+
+size_t PatchCount() {
+    return s_PatchCount;
+}
+
+void PatchBatch::Commit() {
+    if (writes.empty()) return;
+    trace::Span span("mem", "PatchBatch");
+
+    // Stable, so writes to the same address keep their order
+    std::stable_sort(writes.begin(), writes.end(), [](const Write& a, const Write& b) {
+        return a.address < b.address;
+    });
+
+    for (size_t first = 0; first < writes.size();) {
+        size_t last = first;
+        uintptr_t end = writes[first].address + writes[first].size;
+        // Writes on the pages the mapping covers, or the page right after them, join it
+        while (last + 1 < writes.size() &&
+               ALIGN_DOWN(writes[last + 1].address, PAGE_SIZE) <= ALIGN_UP(end, PAGE_SIZE)) {
+            last++;
+            end = std::max(end, writes[last].address + writes[last].size);
+        }
+
+        // RwPages maps size bytes rounded up from the start of ro's page, so a run that crosses into another page
+        // has to be given from the start of its first page. Unmapping it flushes the whole range.
+        uintptr_t start = ALIGN_DOWN(writes[first].address, PAGE_SIZE);
+        const exl::util::RwPages control(start, ALIGN_UP(end, PAGE_SIZE) - start);
+        for (size_t i = first; i <= last; i++) {
+            void *rw = reinterpret_cast<void*>(control.GetRw() + (writes[i].address - control.GetRo()));
+            ::memcpy(rw, &data[writes[i].offset], writes[i].size);
+        }
+
+        first = last + 1;
+    }
+
+    s_PatchCount += writes.size();
+    writes.clear();
+    data.clear();
+}
+
+void Trampoline(PatchBatch &patches, uintptr_t address, uintptr_t target, reg::Register reg) {    
     if ((address & 3) || (target & 3) || reg.Index() > 31) ::abort();
 
     if (address == 0) { Logging.Log("Invalid address. Skipping."); return; }
     if (target == 0) { Logging.Log("Invalid target. Skipping."); return; }
 
-    Overwrite(address,          inst::BranchLink(codeCaves - address).Value());
-    Overwrite(codeCaves + 0,    inst::LdrLiteral(reg, 0x8).Value());
-    Overwrite(codeCaves + 4,    inst::BranchRegister(reg).Value());
-    Overwrite(codeCaves + 8,    target);
+    patches.Overwrite(address,          inst::BranchLink(codeCaves - address).Value());
+    patches.Overwrite(codeCaves + 0,    inst::LdrLiteral(reg, 0x8).Value());
+    patches.Overwrite(codeCaves + 4,    inst::BranchRegister(reg).Value());
+    patches.Overwrite(codeCaves + 8,    target);
     codeCaves += 0x10;
 }
 
 uintptr_t AssemblePointer(uintptr_t adrp_addr, ptrdiff_t ldr_offset) {
+    // The ADRP gives the pointer's page, the load/store after it the offset within that page
     uint32_t pageAddrOffsetInst = *reinterpret_cast<uint32_t*>(adrp_addr);
-    // Extracting the offset from the current page to the pointer's page from the instruction
-    // immhi:immlo * 4096
-    uint64_t immhi = (pageAddrOffsetInst >> 5) & 0x1FFF;
-    uint64_t immlo = (pageAddrOffsetInst >> 29) & 0b11;
-    uint64_t offsetFromPage = ((immhi << 2) | immlo) << 12;
-    // Adding offset to current page address to get target page address
-    uintptr_t pageAddr = (adrp_addr & 0xFFFFFFFFFFFFF000) + offsetFromPage;
-    // Extracting the offset from the target page address to the pointer's address from the next instruction
     uint32_t offsetFromPageStartInst = *reinterpret_cast<uint32_t*>(adrp_addr + ldr_offset);
-    uint32_t offsetFromPageStart = ((offsetFromPageStartInst >> 10) & 0xFFF) << (((offsetFromPageStartInst) >> 30) & 0b11);
-    
-    return pageAddr + offsetFromPageStart;
+
+    return DecodePointer(adrp_addr, pageAddrOffsetInst, offsetFromPageStartInst);
 }
 
 }  // namespace mem
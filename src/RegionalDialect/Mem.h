@@ -2,31 +2,62 @@
 
 #include <cstdint>
 #include <cstring>
+#include <vector>
 
 #include <lib/armv8.hpp>
 #include <util/sys/rw_pages.hpp>
 
+#include "Trace.h"
+
 namespace inst = exl::armv8::inst;
 namespace reg = exl::armv8::reg;
 
 namespace rd {
 namespace mem {
 
-template <typename T>
-inline void Overwrite(uintptr_t address, const T &value) {
-    static_assert(std::is_trivially_copyable_v<T>, "Type must be trivially copyable!");
+    // Writes to the game's read-only memory, applied together when the batch is committed or goes away.
+    // Writes on the same or neighbouring pages share one RW mapping, whose caches are flushed once as it's
+    // unmapped, rather than each write mapping, flushing and unmapping its page on its own.
+    class PatchBatch {
+      public:
+        PatchBatch() = default;
+        ~PatchBatch() { Commit(); }
+
+        PatchBatch(const PatchBatch&) = delete;
+        PatchBatch& operator=(const PatchBatch&) = delete;
+
+        template <typename T>
+        void Overwrite(uintptr_t address, const T &value) {
+            static_assert(std::is_trivially_copyable_v<T>, "Type must be trivially copyable!");
+
+            if (address == 0) [[ unlikely ]] {
+                Logging.Log("Null pointer passed to rd::mem::PatchBatch::Overwrite. Ignoring...\n");
+                return;
+            }
+
+            Add(address, &value, sizeof(T));
+        }
+
+        // Applies the writes so far, a later write to the same bytes wins. The batch can be used again after.
+        void Commit();
+
+      private:
+        struct Write {
+            uintptr_t address;
+            size_t offset;  // Into data
+            size_t size;
+        };
+
+        void Add(uintptr_t address, const void *value, size_t size);
 
-    if (address == 0) [[ unlikely ]] {
-        Logging.Log("Null pointer passed to rd::mem::Overwrite. Ignoring...\n");
-        return;
-    }
+        std::vector<Write> writes;
+        std::vector<uint8_t> data;
+    };
 
-    exl::util::RwPages control(address, sizeof(T));
-    ::memcpy(reinterpret_cast<void*>(control.GetRw()), &value, sizeof(T));
-    control.Flush();
-}
+    // Writes PatchBatch has applied so far
+    size_t PatchCount();
 
-void Trampoline(uintptr_t address, uintptr_t target, reg::Register reg);
+void Trampoline(PatchBatch &patches, uintptr_t address, uintptr_t target, reg::Register reg);
 
 uintptr_t AssemblePointer(uintptr_t adrp_addr, ptrdiff_t ldr_offset);
 
@@ -0,0 +1,46 @@
+#include "Patchdef.h"
+
+namespace rd {
+namespace config {
+
+static float ReadFloat(const cJSON *object, const char *key) {
+    const cJSON *item = ::cJSON_GetObjectItem(object, key);
+    return ::cJSON_IsNumber(item) ? static_cast<float>(item->valuedouble) : 0.0f;
+}
+
+static bool ReadBool(const cJSON *object, const char *key) {
+    return ::cJSON_IsTrue(::cJSON_GetObjectItem(object, key));
+}
+
+Patchdef ReadPatchdef(const cJSON *base) {
+    Patchdef patchdef;
+    patchdef.hookText = ReadBool(base, "hookText");
+    patchdef.outlinedFont = ReadBool(base, "outlinedFont");
+    patchdef.addNametags = ReadBool(base, "addNametags");
+    patchdef.addBacklogOutline = ReadBool(base, "addBacklogOutline");
+    patchdef.tipReimplementation = ReadBool(base, "tipReimplementation");
+    patchdef.chnRedoChat = ReadBool(base, "chnRedoChat");
+
+    patchdef.atlasDialogueMargin = ReadFloat(base, "atlasDialogueMargin");
+    patchdef.atlasOutlineMargin = ReadFloat(base, "atlasOutlineMargin");
+    patchdef.dialogueOutlineOffset = ReadFloat(base, "dialogueOutlineOffset");
+
+    const char *layout = ::cJSON_GetStringValue(::cJSON_GetObjectItem(base, "nametagOptionLayout"));
+    patchdef.nametagOptionLayout = layout ? layout : "";
+
+    // Instructions are keyed by name, an array of them comes without any
+    const cJSON *inst;
+    cJSON_ArrayForEach(inst, ::cJSON_GetObjectItem(base, "customInstructions")) {
+        patchdef.instructions.push_back({
+            .name = inst->string ? inst->string : "",
+            .table = static_cast<int>(ReadFloat(inst, "table")),
+            .opcode = static_cast<int>(ReadFloat(inst, "opcode")),
+        });
+    }
+    patchdef.customInstructions = !patchdef.instructions.empty();
+
+    return patchdef;
+}
+
+}  // namespace config
+}  // namespace rd
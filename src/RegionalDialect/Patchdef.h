@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <cJSON/cJSON.h>
+
+namespace rd {
+namespace config {
+
+    // A custom VM instruction to put in a script table slot, see vm::InsertCustomInstructions
+    struct CustomInstruction {
+        std::string name;
+        int table = 0;
+        int opcode = 0;
+    };
+
+    // patchdef.json's "base", missing keys are off or 0
+    struct Patchdef {
+        bool hookText = false;
+        bool outlinedFont = false;
+        bool addNametags = false;
+        bool addBacklogOutline = false;
+        bool tipReimplementation = false;
+        bool chnRedoChat = false;
+        bool customInstructions = false;  // Whether instructions has any
+
+        float atlasDialogueMargin = 0.0f;
+        float atlasOutlineMargin = 0.0f;
+        float dialogueOutlineOffset = 0.0f;
+
+        std::string nametagOptionLayout;
+        std::vector<CustomInstruction> instructions;
+    };
+
+    // Reads patchdef.json's "base" object, which the tree may be freed after
+    Patchdef ReadPatchdef(const cJSON *base);
+
+}  // namespace config
+}  // namespace rd
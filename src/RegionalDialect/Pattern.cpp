@@ -0,0 +1,489 @@
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstring>
+#include <string>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#ifdef __SWITCH__
+#include <common.hpp>
+#include <nn/os.hpp>
+#else
+#include <thread>
+#endif
+
+#include "Pattern.h"
+#include "Trace.h"
+
+using namespace std;
+
+namespace rd {
+namespace hook {
+
+bool Pattern::Compile(string_view text) {
+    value.assign(text.size() / 2 + 1, 0);
+    mask.assign(text.size() / 2 + 1, 0);
+    size_t size = detail::CompilePattern(text, value.data(), mask.data());
+
+    size_t padded = (size + PatternView::VectorSize - 1) / PatternView::VectorSize * PatternView::VectorSize;
+    value.resize(padded, 0);
+    mask.resize(padded, 0);
+
+    view = { value.data(), mask.data(), size, padded };
+    view.SelectAnchors();
+    return size != 0;
+}
+
+bool Pattern::CompileInsns(string_view text) {
+    value.assign(text.size() / 2 + 1, 0);
+    mask.assign(text.size() / 2 + 1, 0);
+    size_t size = detail::CompileInsns(text, value.data(), mask.data());
+
+    size_t padded = (size + PatternView::VectorSize - 1) / PatternView::VectorSize * PatternView::VectorSize;
+    value.resize(padded, 0);
+    mask.resize(padded, 0);
+
+    view = { value.data(), mask.data(), size, padded };
+    view.alignment = 4;
+    view.SelectAnchors();
+    return size != 0;
+}
+
+bool PatternView::Match(const uint8_t* data, const uint8_t* dataEnd) const {
+    size_t available = dataEnd - data;
+    if (available < size) return false;
+
+    // The padding is masked out, but is only safe to read when it's still inside the data
+    if (available >= paddedSize) {
+        for (size_t k = 0; k < paddedSize; k += VectorSize) {
+#if defined(__ARM_NEON)
+            uint8x16_t eq = vceqq_u8(vandq_u8(vld1q_u8(data + k), vld1q_u8(&mask[k])), vld1q_u8(&value[k]));
+            if (vminvq_u8(eq) != 0xFF) return false;
+#elif defined(__SSE2__)
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + k));
+            __m128i masked = _mm_and_si128(bytes, _mm_loadu_si128(reinterpret_cast<const __m128i*>(&mask[k])));
+            __m128i eq = _mm_cmpeq_epi8(masked, _mm_loadu_si128(reinterpret_cast<const __m128i*>(&value[k])));
+            if (_mm_movemask_epi8(eq) != 0xFFFF) return false;
+#else
+            for (size_t i = k; i < k + VectorSize; i++)
+                if ((data[i] & mask[i]) != value[i]) return false;
+#endif
+        }
+        return true;
+    }
+
+    for (size_t i = 0; i < size; i++)
+        if ((data[i] & mask[i]) != value[i]) return false;
+    return true;
+}
+
+// Instruction patterns only start on word boundaries, so the anchor word is compared a vector of words at a time
+static const uint8_t* FindAlignedPattern(const uint8_t* dataStart, const uint8_t* dataEnd, PatternView pattern) {
+    const uint8_t* last = dataEnd - pattern.size;
+    const size_t alignment = pattern.alignment;
+    const uint8_t* p = dataStart + (alignment - reinterpret_cast<uintptr_t>(dataStart) % alignment) % alignment;
+
+    if (!pattern.hasAnchor) {
+        for (; p <= last; p += alignment)
+            if (pattern.Match(p, dataEnd)) return p;
+        return dataEnd;
+    }
+
+    const size_t a = pattern.anchor;
+    uint32_t wordValue, wordMask;
+    memcpy(&wordValue, &pattern.value[a], sizeof(wordValue));
+    memcpy(&wordMask, &pattern.mask[a], sizeof(wordMask));
+
+#if defined(__ARM_NEON)
+    const uint32x4_t v = vdupq_n_u32(wordValue), m = vdupq_n_u32(wordMask);
+    for (; p <= last && static_cast<size_t>(dataEnd - p) >= a + 16; p += 16) {
+        uint32x4_t eq = vceqq_u32(vandq_u32(vld1q_u32(reinterpret_cast<const uint32_t*>(p + a)), m), v);
+        // Sixteen bits per lane
+        uint64_t bits = vget_lane_u64(vreinterpret_u64_u16(vmovn_u32(eq)), 0);
+        while (bits) {
+            size_t lane = __builtin_ctzll(bits) >> 4;
+            bits &= ~(0xFFFFULL << (lane * 16));
+
+            const uint8_t* candidate = p + lane * 4;
+            if (candidate > last) return dataEnd;
+            if (pattern.Match(candidate, dataEnd)) return candidate;
+        }
+    }
+#elif defined(__AVX2__)
+    const __m256i v = _mm256_set1_epi32(wordValue), m = _mm256_set1_epi32(wordMask);
+    for (; p <= last && static_cast<size_t>(dataEnd - p) >= a + 32; p += 32) {
+        __m256i words = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + a));
+        __m256i eq = _mm256_cmpeq_epi32(_mm256_and_si256(words, m), v);
+        for (uint32_t bits = _mm256_movemask_ps(_mm256_castsi256_ps(eq)); bits; bits &= bits - 1) {
+            const uint8_t* candidate = p + __builtin_ctz(bits) * 4;
+            if (candidate > last) return dataEnd;
+            if (pattern.Match(candidate, dataEnd)) return candidate;
+        }
+    }
+#elif defined(__SSE2__)
+    const __m128i v = _mm_set1_epi32(wordValue), m = _mm_set1_epi32(wordMask);
+    for (; p <= last && static_cast<size_t>(dataEnd - p) >= a + 16; p += 16) {
+        __m128i words = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + a));
+        __m128i eq = _mm_cmpeq_epi32(_mm_and_si128(words, m), v);
+        for (uint32_t bits = _mm_movemask_ps(_mm_castsi128_ps(eq)); bits; bits &= bits - 1) {
+            const uint8_t* candidate = p + __builtin_ctz(bits) * 4;
+            if (candidate > last) return dataEnd;
+            if (pattern.Match(candidate, dataEnd)) return candidate;
+        }
+    }
+#endif
+
+    for (; p <= last; p += alignment) {
+        uint32_t word;
+        memcpy(&word, p + a, sizeof(word));
+        if ((word & wordMask) == wordValue && pattern.Match(p, dataEnd)) return p;
+    }
+    return dataEnd;
+}
+
+const uint8_t* FindPattern(const uint8_t* dataStart, const uint8_t* dataEnd, PatternView pattern) {
+    if (pattern.size == 0 || static_cast<size_t>(dataEnd - dataStart) < pattern.size) return dataEnd;
+    if (pattern.alignment > 1) return FindAlignedPattern(dataStart, dataEnd, pattern);
+    const uint8_t* last = dataEnd - pattern.size;
+
+    if (!pattern.hasAnchor) {
+        for (const uint8_t* p = dataStart; p <= last; p++)
+            if (pattern.Match(p, dataEnd)) return p;
+        return dataEnd;
+    }
+
+    const size_t a1 = pattern.anchor, a2 = pattern.anchor2;
+    const uint8_t b1 = pattern.value[a1], b2 = pattern.value[a2];
+    const size_t reach = max(a1, a2);
+    const uint8_t* p = dataStart;
+
+    // Compare both anchors for a block of candidate positions at once,
+    // only positions where both agree get the full comparison
+#if defined(__ARM_NEON)
+    const uint8x16_t v1 = vdupq_n_u8(b1), v2 = vdupq_n_u8(b2);
+    for (; p <= last && static_cast<size_t>(dataEnd - p) >= reach + 16; p += 16) {
+        uint8x16_t eq = vandq_u8(vceqq_u8(vld1q_u8(p + a1), v1), vceqq_u8(vld1q_u8(p + a2), v2));
+        // Four bits per lane
+        uint64_t bits = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+        while (bits) {
+            size_t lane = __builtin_ctzll(bits) >> 2;
+            bits &= ~(0xFULL << (lane * 4));
+
+            const uint8_t* candidate = p + lane;
+            if (candidate > last) return dataEnd;
+            if (pattern.Match(candidate, dataEnd)) return candidate;
+        }
+    }
+#elif defined(__AVX2__)
+    const __m256i v1 = _mm256_set1_epi8(b1), v2 = _mm256_set1_epi8(b2);
+    for (; p <= last && static_cast<size_t>(dataEnd - p) >= reach + 32; p += 32) {
+        __m256i eq1 = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + a1)), v1);
+        __m256i eq2 = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + a2)), v2);
+        for (uint32_t bits = _mm256_movemask_epi8(_mm256_and_si256(eq1, eq2)); bits; bits &= bits - 1) {
+            const uint8_t* candidate = p + __builtin_ctz(bits);
+            if (candidate > last) return dataEnd;
+            if (pattern.Match(candidate, dataEnd)) return candidate;
+        }
+    }
+#elif defined(__SSE2__)
+    const __m128i v1 = _mm_set1_epi8(b1), v2 = _mm_set1_epi8(b2);
+    for (; p <= last && static_cast<size_t>(dataEnd - p) >= reach + 16; p += 16) {
+        __m128i eq1 = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + a1)), v1);
+        __m128i eq2 = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + a2)), v2);
+        for (uint32_t bits = _mm_movemask_epi8(_mm_and_si128(eq1, eq2)); bits; bits &= bits - 1) {
+            const uint8_t* candidate = p + __builtin_ctz(bits);
+            if (candidate > last) return dataEnd;
+            if (pattern.Match(candidate, dataEnd)) return candidate;
+        }
+    }
+#else
+    // memchr is vectorized by the C library, let it find the rarest byte
+    while (p <= last) {
+        const uint8_t* hit = static_cast<const uint8_t*>(memchr(p + a1, b1, last - p + 1));
+        if (!hit) return dataEnd;
+        const uint8_t* candidate = hit - a1;
+        if (candidate[a2] == b2 && pattern.Match(candidate, dataEnd)) return candidate;
+        p = candidate + 1;
+    }
+#endif
+
+    for (; p <= last; p++)
+        if (p[a1] == b1 && p[a2] == b2 && pattern.Match(p, dataEnd)) return p;
+    return dataEnd;
+}
+
+const uint8_t* PatternCursor::Next() {
+    if (position >= dataEnd) return nullptr;
+
+    const uint8_t* match = FindPattern(position, dataEnd, pattern);
+    if (match == dataEnd) {
+        position = dataEnd;
+        return nullptr;
+    }
+
+    // Matches may overlap, so the search resumes right after the start of this one
+    position = match + 1;
+    return match;
+}
+
+uintptr_t FindPattern(const uint8_t* dataStart, const uint8_t* dataEnd, string_view pszPattern,
+                      uintptr_t baseAddress, size_t offset, int occurrence) {
+    Pattern pattern;
+    if (!pattern.Compile(pszPattern) || occurrence < 0) return 0;
+
+    PatternCursor cursor(pattern.view, dataStart, dataEnd);
+    for (int resultCount = 0; const uint8_t* match = cursor.Next(); resultCount++) {
+        if (resultCount == occurrence) return baseAddress + distance(dataStart, match) + offset;
+    }
+
+    return 0;
+}
+
+size_t PatternSet::Add(string_view text, size_t maxMatches) {
+    Pattern pattern;
+    pattern.Compile(text);
+
+    size_t id = Add(pattern.view, maxMatches);
+    entries[id].owned = std::move(pattern);
+    return id;
+}
+
+size_t PatternSet::Add(PatternView pattern, size_t maxMatches) {
+    Entry& entry = entries.emplace_back();
+    entry.maxMatches = maxMatches;
+    entry.pattern = pattern;
+
+    // Longest run of fully specified bytes, there is little to gain past 16
+    for (size_t i = 0; i < pattern.size;) {
+        if (pattern.mask[i] != 0xFF) { i++; continue; }
+
+        size_t len = 0;
+        while (i + len < pattern.size && pattern.mask[i + len] == 0xFF) len++;
+
+        if (len > entry.runLen) {
+            entry.runPos = i;
+            entry.runLen = min<size_t>(len, 16);
+        }
+        i += len;
+    }
+
+    return entries.size() - 1;
+}
+
+int32_t PatternSet::Child(int32_t node, uint8_t byte) const {
+    if (node == 0) return rootNext[byte];
+
+    for (int32_t child = nodes[node].firstChild; child >= 0; child = nodes[child].nextSibling)
+        if (nodes[child].byte == byte) return child;
+    return -1;
+}
+
+void PatternSet::Build() {
+    nodes.clear();
+    nodes.emplace_back();
+    fill(begin(rootNext), end(rootNext), -1);
+
+    for (size_t i = 0; i < entries.size(); i++) {
+        Entry& entry = entries[i];
+        entry.nextSameRun = -1;
+        if (entry.runLen == 0) continue;
+
+        int32_t node = 0;
+        for (size_t k = entry.runPos; k < entry.runPos + entry.runLen; k++) {
+            uint8_t byte = entry.pattern.value[k];
+
+            int32_t next = Child(node, byte);
+            if (next < 0) {
+                next = nodes.size();
+                Node& created = nodes.emplace_back();
+                created.byte = byte;
+
+                if (node == 0) {
+                    rootNext[byte] = next;
+                } else {
+                    created.nextSibling = nodes[node].firstChild;
+                    nodes[node].firstChild = next;
+                }
+            }
+            node = next;
+        }
+
+        entry.nextSameRun = nodes[node].output;
+        nodes[node].output = i;
+    }
+
+    // Breadth-first so every fail target is finished before it's needed
+    vector<int32_t> queue;
+    queue.reserve(nodes.size());
+    for (int32_t child : rootNext)
+        if (child >= 0) queue.push_back(child);
+
+    for (size_t head = 0; head < queue.size(); head++) {
+        int32_t node = queue[head];
+
+        for (int32_t child = nodes[node].firstChild; child >= 0; child = nodes[child].nextSibling) {
+            int32_t fail = nodes[node].fail;
+            int32_t next;
+            while ((next = Child(fail, nodes[child].byte)) < 0 && fail != 0) fail = nodes[fail].fail;
+
+            nodes[child].fail = next < 0 ? 0 : next;
+            nodes[child].outputLink = nodes[nodes[child].fail].output >= 0 ? nodes[child].fail
+                                                                           : nodes[nodes[child].fail].outputLink;
+            queue.push_back(child);
+        }
+    }
+}
+
+void PatternSet::Record(Chunk& chunk, uint32_t id, const uint8_t* match) const {
+    const Entry& entry = entries[id];
+    if (reinterpret_cast<uintptr_t>(match) % entry.pattern.alignment != 0) return;
+    if (!entry.pattern.Match(match, chunk.dataEnd)) return;
+
+    // Chunks before this one may already hold enough, but there's no telling until the merge
+    if (chunk.counts[id]++ < entry.maxMatches) chunk.hits.emplace_back(id, match);
+}
+
+void PatternSet::Restore(size_t id, size_t count, span<const uintptr_t> matches) {
+    Entry& entry = entries[id];
+    entry.count = count;
+    entry.matches.assign(matches.begin(), matches.end());
+}
+
+void PatternSet::ScanChunk(Chunk& chunk) const {
+    chunk.counts.assign(entries.size(), 0);
+
+    // Nothing to anchor on, every position has to be tried
+    for (uint32_t e = 0; e < entries.size(); e++) {
+        const PatternView& pattern = entries[e].pattern;
+        if (entries[e].runLen != 0 || pattern.size == 0) continue;
+
+        size_t alignment = pattern.alignment;
+        const uint8_t* p = chunk.start + (alignment - reinterpret_cast<uintptr_t>(chunk.start) % alignment) % alignment;
+        for (; p < chunk.end; p += alignment) Record(chunk, e, p);
+    }
+
+    // Keep feeding the automaton past the end so runs of matches starting in this chunk are seen too
+    size_t overlap = 0;
+    for (const Entry& entry : entries) overlap = max(overlap, entry.runPos + entry.runLen);
+    const uint8_t* scanEnd = static_cast<size_t>(chunk.dataEnd - chunk.end) > overlap ? chunk.end + overlap : chunk.dataEnd;
+
+    int32_t state = 0;
+    for (const uint8_t* p = chunk.start; p < scanEnd; p++) {
+        int32_t next;
+        while ((next = Child(state, *p)) < 0 && state != 0) state = nodes[state].fail;
+        state = next < 0 ? 0 : next;
+
+        int32_t out = nodes[state].output >= 0 ? state : nodes[state].outputLink;
+        for (; out >= 0; out = nodes[out].outputLink) {
+            for (int32_t e = nodes[out].output; e >= 0; e = entries[e].nextSameRun) {
+                const Entry& entry = entries[e];
+                size_t end = p - chunk.start + 1;
+                if (end < entry.runPos + entry.runLen) continue;
+
+                const uint8_t* match = p + 1 - entry.runLen - entry.runPos;
+                if (match < chunk.end) Record(chunk, e, match);
+            }
+        }
+    }
+}
+
+void PatternSet::RunChunk(void* arg) {
+    trace::Span span("sigscan", "scan chunk");
+    Chunk& chunk = *static_cast<Chunk*>(arg);
+    chunk.set->ScanChunk(chunk);
+}
+
+#ifdef __SWITCH__
+// Stacks for the workers besides the calling thread, the automaton barely needs any
+static constexpr size_t WorkerStackSize = 0x4000;
+alignas(nn::os::ThreadStackAlignment) static uint8_t s_WorkerStacks[PatternSet::MaxWorkers - 1][WorkerStackSize];
+static nn::os::ThreadType s_WorkerThreads[PatternSet::MaxWorkers - 1];
+
+// The cores the process may run on, starting with the caller's, so each chunk gets a core of its own
+static size_t ScanCores(s32 (&cores)[PatternSet::MaxWorkers]) {
+    u64 mask = nn::os::GetThreadAvailableCoreMask();
+    s32 current = nn::os::GetCurrentCoreNumber();
+
+    size_t count = 0;
+    cores[count++] = current;
+    for (s32 i = 1; i < 64 && count < PatternSet::MaxWorkers; i++) {
+        s32 core = (current + i) % 64;
+        if (mask & (1ul << core)) cores[count++] = core;
+    }
+    return count;
+}
+#endif
+
+void PatternSet::Scan(const uint8_t* dataStart, const uint8_t* dataEnd, uintptr_t baseAddress, size_t workers) {
+    trace::Span span("sigscan", "batch scan");
+    Build();
+
+    // Small inputs aren't worth a thread
+    size_t dataSize = dataEnd - dataStart;
+    workers = clamp<size_t>(min(workers, dataSize / 0x10000), 1, MaxWorkers);
+#ifdef __SWITCH__
+    s32 cores[MaxWorkers];
+    workers = min(workers, ScanCores(cores));
+#endif
+
+    Chunk chunks[MaxWorkers];
+    for (size_t i = 0; i < workers; i++) {
+        chunks[i].set = this;
+        chunks[i].start = dataStart + dataSize * i / workers;
+        chunks[i].end = dataStart + dataSize * (i + 1) / workers;
+        chunks[i].dataEnd = dataEnd;
+    }
+
+#ifdef __SWITCH__
+    bool started[MaxWorkers - 1] = {};
+    for (size_t i = 1; i < workers; i++) {
+        Result rc = nn::os::CreateThread(&s_WorkerThreads[i - 1], RunChunk, &chunks[i], s_WorkerStacks[i - 1],
+                                         WorkerStackSize, nn::os::DefaultThreadPriority, cores[i]);
+        if (R_FAILED(rc)) continue;
+
+        nn::os::StartThread(&s_WorkerThreads[i - 1]);
+        started[i - 1] = true;
+    }
+
+    RunChunk(&chunks[0]);
+
+    // Any chunk whose thread couldn't be created is scanned here instead
+    for (size_t i = 1; i < workers; i++) {
+        if (!started[i - 1]) {
+            RunChunk(&chunks[i]);
+            continue;
+        }
+
+        nn::os::WaitThread(&s_WorkerThreads[i - 1]);
+        nn::os::DestroyThread(&s_WorkerThreads[i - 1]);
+    }
+#else
+    vector<thread> threads;
+    for (size_t i = 1; i < workers; i++) threads.emplace_back(RunChunk, &chunks[i]);
+
+    RunChunk(&chunks[0]);
+    for (thread& worker : threads) worker.join();
+#endif
+
+    for (Entry& entry : entries) {
+        entry.count = 0;
+        entry.matches.clear();
+    }
+
+    for (size_t i = 0; i < workers; i++) {
+        for (auto [id, match] : chunks[i].hits) {
+            Entry& entry = entries[id];
+            if (entry.matches.size() < entry.maxMatches) entry.matches.push_back(baseAddress + (match - dataStart));
+        }
+
+        for (size_t id = 0; id < entries.size(); id++) entries[id].count += chunks[i].counts[id];
+    }
+}
+
+}  // namespace hook
+}  // namespace rd
@@ -0,0 +1,319 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace rd {
+namespace hook {
+
+    namespace detail {
+
+        // Byte values seen most often in AArch64 code, most common first: register fields,
+        // zero immediates and the top bytes of add/ldr/str/bl/mov/stp/ret and friends
+        inline constexpr uint8_t CommonBytes[] = {
+            0x00, 0xFF, 0xE0, 0x03, 0x91, 0xF9, 0x40, 0x01, 0x02, 0x1F, 0x08, 0xB9, 0xAA, 0x94, 0x97,
+            0x52, 0x2A, 0x80, 0xE8, 0x20, 0x60, 0xA9, 0xFD, 0x7B, 0xD6, 0x5F, 0x34, 0x35, 0x54, 0x14,
+            0x17, 0xF4, 0xF3, 0x13, 0x09, 0x0A, 0x21, 0xE1, 0xE2, 0x39, 0x71, 0x6B, 0xD1, 0xB4, 0xB5,
+            0xA8, 0xBD, 0x1E, 0x90, 0xB0, 0xD0, 0xF0, 0x10, 0x04, 0x05, 0x06, 0x07, 0x0B, 0x12, 0x36,
+            0x37, 0x79, 0x1A, 0x9A, 0xD2, 0xF8, 0xB8, 0x4E, 0x3D, 0x2D, 0x6D, 0xC0, 0x3F,
+        };
+
+        // Higher is rarer, everything not listed is considered equally rare
+        inline constexpr std::array<uint8_t, 256> ByteRarity = [] {
+            std::array<uint8_t, 256> rarity{};
+            rarity.fill(0xFF);
+            for (size_t i = 0; i < std::size(CommonBytes); i++) rarity[CommonBytes[i]] = i;
+            return rarity;
+        }();
+
+        constexpr int HexChToInt(char ch) {
+            if (ch >= '0' && ch <= '9')
+                return ch - '0';
+            else if (ch >= 'A' && ch <= 'F')
+                return ch - 'A' + 10;
+            else if (ch >= 'a' && ch <= 'f')
+                return ch - 'a' + 10;
+            return -1;
+        }
+
+        // Writes at most text.size() / 2 + 1 bytes, returns how many the pattern has.
+        // Two nibbles per byte, a trailing lone nibble leaves the low one as a wildcard.
+        constexpr size_t CompilePattern(std::string_view text, uint8_t* value, uint8_t* mask) {
+            size_t size = 0;
+            bool highNibble = true;
+
+            for (char ch : text) {
+                int nibble = HexChToInt(ch);
+                if (ch != '?' && nibble < 0) continue;
+
+                if (highNibble) {
+                    value[size] = 0;
+                    mask[size] = 0;
+                    size++;
+                }
+
+                if (ch != '?') {
+                    int shift = highNibble ? 4 : 0;
+                    value[size - 1] |= nibble << shift;
+                    mask[size - 1] |= 0xF << shift;
+                }
+                highNibble = !highNibble;
+            }
+
+            return size;
+        }
+
+        // Reads up to 8 hex digits, '?' digits are cleared from the mask when there is one
+        constexpr size_t ReadWord(std::string_view text, size_t pos, uint32_t& value, uint32_t* mask) {
+            size_t start = pos;
+            for (; pos < text.size() && pos - start < 8; pos++) {
+                int nibble = HexChToInt(text[pos]);
+                if (nibble < 0 && (text[pos] != '?' || !mask)) break;
+
+                value = value << 4 | (nibble < 0 ? 0 : nibble);
+                if (mask) *mask = *mask << 4 | (nibble < 0 ? 0 : 0xF);
+            }
+            return pos - start;
+        }
+
+        // Instruction words such as "94000000/FC000000 F9400000/FFC003FF", each one an 8 digit value
+        // with an optional mask after a slash. Writes the words little-endian, at most text.size() / 2 bytes,
+        // and returns how many bytes the pattern has, 0 if it's malformed.
+        constexpr size_t CompileInsns(std::string_view text, uint8_t* value, uint8_t* mask) {
+            size_t size = 0;
+
+            for (size_t pos = 0;;) {
+                while (pos < text.size() && (text[pos] == ' ' || text[pos] == ',')) pos++;
+                if (pos == text.size()) return size;
+
+                uint32_t wordValue = 0, wordMask = 0;
+                size_t digits = ReadWord(text, pos, wordValue, &wordMask);
+                if (digits != 8) return 0;
+                pos += digits;
+
+                if (pos < text.size() && text[pos] == '/') {
+                    uint32_t explicitMask = 0;
+                    digits = ReadWord(text, ++pos, explicitMask, nullptr);
+                    if (digits != 8) return 0;
+                    pos += digits;
+                    wordMask &= explicitMask;
+                }
+
+                if (pos < text.size() && text[pos] != ' ' && text[pos] != ',') return 0;
+
+                for (int i = 0; i < 4; i++) {
+                    value[size] = (wordValue & wordMask) >> (i * 8);
+                    mask[size] = wordMask >> (i * 8);
+                    size++;
+                }
+            }
+        }
+
+    }  // namespace detail
+
+    // Non-owning view of a compiled pattern, a byte matches when (byte & mask) == value
+    struct PatternView {
+        static constexpr size_t VectorSize = 16;
+
+        // Both padded with zeroes to paddedSize, a multiple of VectorSize, so they can be compared a vector at a time
+        const uint8_t* value = nullptr;
+        const uint8_t* mask = nullptr;
+        size_t size = 0;
+        size_t paddedSize = 0;
+
+        // The two rarest fully specified bytes, candidates are located with them before a full comparison.
+        // Instruction patterns use the word with the most mask bits instead, anchor is its offset.
+        size_t anchor = 0;
+        size_t anchor2 = 0;
+        bool hasAnchor = false;
+
+        // Matches only start at addresses that are a multiple of this, 4 for instruction patterns
+        size_t alignment = 1;
+
+        constexpr void SelectAnchors() {
+            hasAnchor = false;
+
+            if (alignment == 4) {
+                int bits = 0;
+                for (size_t i = 0; i + 4 <= size; i += 4) {
+                    uint32_t wordMask = mask[i] | mask[i + 1] << 8 | mask[i + 2] << 16 | mask[i + 3] << 24;
+                    int wordBits = std::popcount(wordMask);
+                    if (wordBits > bits) {
+                        bits = wordBits;
+                        anchor = anchor2 = i;
+                        hasAnchor = true;
+                    }
+                }
+                return;
+            }
+
+            for (size_t i = 0; i < size; i++) {
+                if (mask[i] != 0xFF) continue;
+
+                const auto& rarity = detail::ByteRarity;
+                if (!hasAnchor || rarity[value[i]] > rarity[value[anchor]]) {
+                    anchor2 = hasAnchor ? anchor : i;
+                    anchor = i;
+                    hasAnchor = true;
+                } else if (anchor2 == anchor || rarity[value[i]] >= rarity[value[anchor2]]) {
+                    anchor2 = i;
+                }
+            }
+        }
+
+        bool Match(const uint8_t* data, const uint8_t* dataEnd) const;
+    };
+
+    // A pattern string such as "F9 ?? 40 B?" compiled onto the heap, or a view of one compiled ahead of time
+    // into config.bin, in which case value and mask are empty and the view points into the blob
+    struct Pattern {
+        std::vector<uint8_t> value;
+        std::vector<uint8_t> mask;
+        PatternView view;
+
+        Pattern() = default;
+        Pattern(const Pattern&) = delete;
+        Pattern& operator=(const Pattern&) = delete;
+        // Moving keeps the buffers, so the view stays valid
+        Pattern(Pattern&&) = default;
+        Pattern& operator=(Pattern&&) = default;
+
+        bool Compile(std::string_view text);
+
+        // Instruction words with bit masks, see detail::CompileInsns. Only tried at 4-byte aligned addresses.
+        bool CompileInsns(std::string_view text);
+    };
+
+    // A pattern compiled at build time, see MakePattern
+    template <size_t Capacity>
+    struct StaticPattern {
+        std::array<uint8_t, Capacity> value{};
+        std::array<uint8_t, Capacity> mask{};
+        size_t size = 0;
+        size_t anchor = 0;
+        size_t anchor2 = 0;
+        bool hasAnchor = false;
+
+        constexpr PatternView View() const {
+            return { value.data(), mask.data(), size, Capacity, anchor, anchor2, hasAnchor };
+        }
+    };
+
+    // constexpr auto pattern = MakePattern("F9 ?? 40 B?"); never touches the heap
+    template <size_t N>
+    consteval auto MakePattern(const char (&text)[N]) {
+        constexpr size_t Capacity = (N / 2 + PatternView::VectorSize) / PatternView::VectorSize * PatternView::VectorSize;
+
+        StaticPattern<Capacity> pattern;
+        pattern.size = detail::CompilePattern(std::string_view(text, N - 1), pattern.value.data(), pattern.mask.data());
+
+        PatternView view = pattern.View();
+        view.SelectAnchors();
+        pattern.anchor = view.anchor;
+        pattern.anchor2 = view.anchor2;
+        pattern.hasAnchor = view.hasAnchor;
+        return pattern;
+    }
+
+    // Returns the first match within [dataStart, dataEnd), or dataEnd if there is none
+    const uint8_t* FindPattern(const uint8_t* dataStart, const uint8_t* dataEnd, PatternView pattern);
+
+    // Visits every match of a pattern in one forward pass, the pattern's bytes must outlive the cursor
+    class PatternCursor {
+      public:
+        PatternCursor(PatternView pattern, const uint8_t* dataStart, const uint8_t* dataEnd)
+            : pattern(pattern), position(dataStart), dataEnd(dataEnd) {}
+
+        // Returns the next match, or nullptr once there are none left
+        const uint8_t* Next();
+
+      private:
+        PatternView pattern;
+        const uint8_t* position;
+        const uint8_t* dataEnd;
+    };
+
+    uintptr_t FindPattern(const uint8_t* dataStart, const uint8_t* dataEnd, std::string_view pszPattern,
+                          uintptr_t baseAddress, size_t offset, int occurrence);
+
+    // Resolves any number of patterns in a single pass over the data.
+    // Every pattern contributes its longest run of fully specified bytes (its anchor) to an
+    // Aho-Corasick automaton, and each anchor hit is then verified against the whole pattern.
+    class PatternSet {
+      public:
+        static constexpr size_t AllMatches = SIZE_MAX;
+
+        // Returns the id to query results with; keeps at most maxMatches addresses for it
+        size_t Add(std::string_view pattern, size_t maxMatches = 1);
+
+        // Same, but the pattern's bytes are only referenced and must outlive the set
+        size_t Add(PatternView pattern, size_t maxMatches = 1);
+
+        // The Switch gives applications three cores
+        static constexpr size_t MaxWorkers = 3;
+
+        // Splits the data into one overlapping chunk per worker, the calling thread takes the first.
+        // Results are merged in chunk order so they're identical to scanning with a single worker.
+        void Scan(const uint8_t* dataStart, const uint8_t* dataEnd, uintptr_t baseAddress, size_t workers = 1);
+
+        size_t Size() const { return entries.size(); }
+
+        // Total number of matches, including the ones that were not kept
+        size_t Count(size_t id) const { return entries[id].count; }
+
+        std::span<const uintptr_t> Matches(size_t id) const { return entries[id].matches; }
+
+        // Fills in the results of a previous scan of the same data instead of scanning again
+        void Restore(size_t id, size_t count, std::span<const uintptr_t> matches);
+
+      private:
+        struct Entry {
+            Pattern owned;  // Only for patterns added as text
+            PatternView pattern;
+            size_t runPos = 0;
+            size_t runLen = 0;
+            size_t maxMatches = 0;
+            size_t count = 0;
+            int32_t nextSameRun = -1;
+            std::vector<uintptr_t> matches;
+        };
+
+        // Trie stored as first-child/next-sibling, the root's children are in rootNext
+        struct Node {
+            int32_t firstChild = -1;
+            int32_t nextSibling = -1;
+            int32_t fail = 0;
+            int32_t output = -1;      // First entry whose run ends here
+            int32_t outputLink = -1;  // Closest node on the fail chain with an output
+            uint8_t byte = 0;
+        };
+
+        // Matches starting within [start, end) found by one worker
+        struct Chunk {
+            const PatternSet* set;
+            const uint8_t* start;
+            const uint8_t* end;
+            const uint8_t* dataEnd;
+            std::vector<uint32_t> counts;
+            std::vector<std::pair<uint32_t, const uint8_t*>> hits;  // Entry index and match, in data order per entry
+        };
+
+        std::vector<Entry> entries;
+        std::vector<Node> nodes;
+        int32_t rootNext[256];
+
+        int32_t Child(int32_t node, uint8_t byte) const;
+        void Build();
+        void Record(Chunk& chunk, uint32_t id, const uint8_t* match) const;
+        void ScanChunk(Chunk& chunk) const;
+        static void RunChunk(void* chunk);
+    };
+
+}  // namespace hook
+}  // namespace rd
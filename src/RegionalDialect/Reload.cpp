@@ -0,0 +1,53 @@
+#include <lib.hpp>
+#include <log/logger_mgr.hpp>
+#include <nn/os.hpp>
+#include <skyline/utils/cpputils.hpp>
+
+#include "Config.h"
+#include "Feature.h"
+#include "Reload.h"
+#include "Sd.h"
+
+namespace rd {
+namespace reload {
+
+#ifdef RD_DEVELOPER
+
+// Parsing the patchdef keeps its state on the heap, but cJSON recurses
+static constexpr size_t StackSize = 0x8000;
+alignas(nn::os::ThreadStackAlignment) static uint8_t s_Stack[StackSize];
+static nn::os::ThreadType s_Thread;
+static std::string s_RomMount;
+
+static void Poll(void*) {
+    while (true) {
+        nn::os::SleepThread(nn::TimeSpan::FromSeconds(1));
+
+        nn::fs::DirectoryEntryType type;
+        if (!sd::Mount() || R_FAILED(nn::fs::GetEntryType(&type, MarkerPath))) continue;
+        nn::fs::DeleteFile(MarkerPath);
+
+        Logging.Log("Reload: %s found, reloading the patchdef\n", MarkerPath);
+        if (rd::config::ReloadPatchdef(s_RomMount))
+            rd::feature::Reload(rd::config::Live());
+        else
+            Logging.Log("Reload: keeping the current patchdef\n");
+    }
+}
+
+void Start(std::string romMount) {
+    s_RomMount = std::move(romMount);
+
+    Result rc = nn::os::CreateThread(&s_Thread, Poll, nullptr, s_Stack, StackSize, nn::os::LowestThreadPriority, 1);
+    if (R_FAILED(rc)) {
+        Logging.Log("Reload: failed to create the reload thread, the patchdef won't reload: 0x%x\n", rc);
+        return;
+    }
+
+    nn::os::SetThreadNamePointer(&s_Thread, "RegionalDialect reload");
+    nn::os::StartThread(&s_Thread);
+}
+#endif
+
+}  // namespace reload
+}  // namespace rd
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+
+namespace rd {
+namespace reload {
+
+    // Creating this file reloads the patchdef while the game runs, the file is deleted once it's been seen
+    inline constexpr const char* MarkerPath = "sd:/RegionalDialect/reload";
+
+    // Polls for MarkerPath on a low priority thread, call once the features are initialized.
+    // Only developer builds (-DRD_DEVELOPER=ON) have the thread, everywhere else this does nothing.
+#ifdef RD_DEVELOPER
+    void Start(std::string romMount);
+#else
+    inline void Start(std::string) {}
+#endif
+
+}  // namespace reload
+}  // namespace rd
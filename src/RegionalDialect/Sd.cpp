@@ -0,0 +1,40 @@
+#include <lib.hpp>
+#include <log/logger_mgr.hpp>
+#include <skyline/utils/cpputils.hpp>
+
+#include "Sd.h"
+
+namespace rd {
+namespace sd {
+
+bool Mount() {
+    static bool mounted = false;
+    if (mounted) return true;
+
+    Result rc = nn::fs::MountSdCardForDebug("sd");
+    if (R_FAILED(rc)) {
+        Logging.Log("Sd: failed to mount SD card: 0x%x\n", rc);
+        return false;
+    }
+
+    mounted = true;
+    return true;
+}
+
+bool WriteFile(const std::string& path, const void* data, size_t size) {
+    if (!Mount()) return false;
+
+    // writeFile never shrinks an existing file
+    nn::fs::CreateDirectory(Directory);
+    nn::fs::DeleteFile(path.c_str());
+
+    Result rc = skyline::utils::writeFile(path, 0, const_cast<void*>(data), size);
+    if (R_FAILED(rc)) {
+        Logging.Log("Sd: failed to write %s: 0x%x\n", path.c_str(), rc);
+        return false;
+    }
+    return true;
+}
+
+}  // namespace sd
+}  // namespace rd
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace rd {
+namespace sd {
+
+    // Where everything the module writes to the SD card goes
+    inline constexpr const char* Directory = "sd:/RegionalDialect";
+
+    // Mounts the SD card as sd:/ on first use
+    bool Mount();
+
+    // Replaces the file at path, creating Directory if needed
+    bool WriteFile(const std::string& path, const void* data, size_t size);
+
+}  // namespace sd
+}  // namespace rd
@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <lib.hpp>
+#include <lib/libsetting.hpp>
+#include <log/logger_mgr.hpp>
+#include <skyline/utils/cpputils.hpp>
+
+#include "Config.h"
+#include "Sd.h"
+#include "SigCache.h"
+
+using namespace std;
+
+namespace rd {
+namespace hook {
+
+// Layout, all little-endian words: header, then per batch entry its total
+// match count, the number of kept matches and their offsets from .text
+struct CacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t entryCount;
+    uint32_t wordCount;
+};
+
+static constexpr uint32_t CacheMagic = 0x43534452;  // "RDSC"
+static constexpr uint32_t CacheVersion = 1;
+static string CachePath() {
+    char path[64];
+    snprintf(path, sizeof(path), "%s/sigcache_%016lX.bin", sd::Directory, exl::setting::ProgramId);
+    return path;
+}
+
+// An ELF note, the linker puts the one holding the GNU build ID at the start of .rodata
+struct Note {
+    uint32_t nameSize;
+    uint32_t descSize;
+    uint32_t type;
+    char name[4];
+};
+
+static constexpr uint32_t NoteGnuBuildId = 3;
+static constexpr size_t BuildIdSearchSize = 0x1000;
+
+// The module's build ID, empty when it has none
+static span<const char> FindBuildId(const exl::util::ModuleInfo& module) {
+    uintptr_t start = module.m_Rodata.m_Start;
+    uintptr_t end = start + min<size_t>(module.m_Rodata.m_Size, BuildIdSearchSize);
+
+    for (uintptr_t address = start; address + sizeof(Note) <= end; address += 4) {
+        const Note* note = reinterpret_cast<const Note*>(address);
+        if (note->nameSize != 4 || note->type != NoteGnuBuildId || memcmp(note->name, "GNU", 4) != 0) continue;
+        if (note->descSize == 0 || note->descSize > 0x20 || address + sizeof(Note) + note->descSize > end) continue;
+
+        return { reinterpret_cast<const char*>(note + 1), note->descSize };
+    }
+    return {};
+}
+
+uint64_t ScanCacheKey(const exl::util::ModuleInfo& module, uint32_t selection) {
+    uint32_t buildHash;
+    span<const char> buildId = FindBuildId(module);
+    if (!buildId.empty()) {
+        buildHash = exl::util::Murmur3::Compute(buildId);
+    } else {
+        Logging.Log("SigCache: no build ID, hashing .text for the cache key\n");
+        const char* text = reinterpret_cast<const char*>(module.m_Text.m_Start);
+        buildHash = exl::util::Murmur3::Compute(span<const char>(text, module.m_Text.m_Size));
+    }
+    return (uint64_t)buildHash << 32 | (rd::config::config.gamedefHash ^ selection);
+}
+
+bool LoadScanCache(uint64_t key, PatternSet& batch, uintptr_t textStart) {
+    if (!sd::Mount()) return false;
+
+    const uint32_t* contents;
+    size_t contentsSize;
+    Result rc = skyline::utils::readEntireFile(CachePath(), (void**)(&contents), &contentsSize);
+    if (R_FAILED(rc)) {
+        Logging.Log("SigCache: no cache to load: 0x%x\n", rc);
+        return false;
+    }
+
+    const CacheHeader* header = (const CacheHeader*)contents;
+    size_t words = contentsSize / sizeof(uint32_t);
+    const size_t headerWords = sizeof(CacheHeader) / sizeof(uint32_t);
+    bool valid = contentsSize >= sizeof(CacheHeader) && header->magic == CacheMagic &&
+                 header->version == CacheVersion && header->key == key && header->entryCount == batch.Size() &&
+                 header->wordCount == words - headerWords;
+
+    if (!valid) {
+        Logging.Log("SigCache: cache is stale, rescanning\n");
+        free((void*)contents);
+        return false;
+    }
+
+    vector<uintptr_t> matches;
+    const uint32_t* word = contents + headerWords;
+    const uint32_t* end = contents + words;
+
+    for (size_t id = 0; id < batch.Size(); id++) {
+        if (end - word < 2 || (size_t)(end - word - 2) < word[1]) {
+            Logging.Log("SigCache: cache is truncated, rescanning\n");
+            free((void*)contents);
+            return false;
+        }
+
+        size_t count = word[0], kept = word[1];
+        word += 2;
+
+        matches.clear();
+        for (size_t i = 0; i < kept; i++) matches.push_back(textStart + *word++);
+        batch.Restore(id, count, matches);
+    }
+
+    free((void*)contents);
+    Logging.Log("SigCache: restored %lu patterns from %s\n", batch.Size(), CachePath().c_str());
+    return true;
+}
+
+void SaveScanCache(uint64_t key, const PatternSet& batch, uintptr_t textStart) {
+    const size_t headerWords = sizeof(CacheHeader) / sizeof(uint32_t);
+    vector<uint32_t> words(headerWords);
+
+    for (size_t id = 0; id < batch.Size(); id++) {
+        words.push_back(batch.Count(id));
+        words.push_back(batch.Matches(id).size());
+        for (uintptr_t match : batch.Matches(id)) words.push_back(match - textStart);
+    }
+
+    CacheHeader* header = (CacheHeader*)words.data();
+    *header = { CacheMagic, CacheVersion, key, (uint32_t)batch.Size(), (uint32_t)(words.size() - headerWords) };
+
+    string path = CachePath();
+    if (!sd::WriteFile(path, words.data(), words.size() * sizeof(uint32_t))) return;
+
+    Logging.Log("SigCache: wrote %lu patterns to %s\n", batch.Size(), path.c_str());
+}
+
+}  // namespace hook
+}  // namespace rd
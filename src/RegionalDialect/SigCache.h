@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdint>
+
+#include <lib/util/sys/module_info.hpp>
+
+#include "Pattern.h"
+
+namespace rd {
+namespace hook {
+
+    // Identifies the combination of game binary and gamedef.json a set of scan results is valid for,
+    // selection tells apart the subsets of the gamedef's signatures that get scanned (0 for all of them).
+    // The binary is told apart by its build ID, or by a hash of its .text when it has none.
+    uint64_t ScanCacheKey(const exl::util::ModuleInfo& module, uint32_t selection = 0);
+
+    // Restores the batch results from the SD card, fails on any mismatch with the current key or batch
+    bool LoadScanCache(uint64_t key, PatternSet& batch, uintptr_t textStart);
+
+    void SaveScanCache(uint64_t key, const PatternSet& batch, uintptr_t textStart);
+
+}  // namespace hook
+}  // namespace rd
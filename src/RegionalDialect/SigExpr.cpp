@@ -0,0 +1,264 @@
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <strings.h>
+
+#include <frozen/unordered_map.h>
+#include <frozen/string.h>
+
+#include "Decode.h"
+#include "SigExpr.h"
+
+namespace rd {
+namespace hook {
+
+template <typename... Args>
+static std::string Format(const char* format, Args... args) {
+    char buffer[256];
+    snprintf(buffer, sizeof(buffer), format, args...);
+    return buffer;
+}
+
+class SigExprLexer {
+  private:
+    std::string_view input;
+    size_t pos = 0;
+    constexpr static auto tokenMapping =
+        frozen::make_unordered_map<char, SigExprTokenType>({
+            { '+', Plus,  }, { '-', Minus  },
+            { '*', Deref  }, { '(', LParen },
+            { ')', RParen }, { ',', Comma  },
+        });
+
+  public:
+    SigExprLexer(std::string_view input) : input(input) {}
+
+    bool nextToken(SigExprToken& token, std::string& error) {
+        while (pos < input.size() && std::isspace(input[pos])) pos++;
+
+        decltype(tokenMapping)::const_iterator it;
+
+        if (pos >= input.size()) token = { End, 0 };
+        else if ((it = tokenMapping.find(input[pos])) != tokenMapping.end()) { token = { it->second, 0 }; pos++; }
+        else if (std::isdigit(input[pos])) {
+            char *end;
+            token = { Number, (uintptr_t)std::strtoull(input.data() + pos, &end, 0) };
+            pos = end - input.data();
+        } else if (pos + 2 < input.size() && strncasecmp(input.data() + pos, "ptr", 3) == 0) {
+            token = { Ptr, 0 };
+            pos += 3;
+        } else {
+            error = Format("Lexing error in '%s' at position %lu: Unexpected character: '%c'\n", input.data(), pos, input[pos]);
+            return false;
+        }
+        return true;
+    }
+};
+
+// Emits the program in postfix order, stops at the first error
+class SigExprCompiler {
+  private:
+    std::string_view input;
+    const SigExprToken* token;
+    std::vector<SigExprOp>& program;
+    std::string& error;
+    size_t depth = 0;
+    constexpr static auto tokenType =
+        frozen::make_unordered_map<SigExprTokenType, frozen::string>({
+            { Start,  "Start"  }, { Plus,   "Plus"   },
+            { Minus,  "Minus"  }, { Deref,  "Deref"  },
+            { LParen, "LParen" }, { RParen, "RParen" },
+            { Comma,  "Comma"  }, { Number, "Number" },
+            { Ptr,    "Ptr"    }, { End,    "End"    }
+        });
+
+    SigExprToken getToken() const { return *token; }
+
+    // The lexer always ends the tokens with End, which is never stepped past
+    void nextToken() {
+        if (token->type != End) token++;
+    }
+
+    bool failed() const { return !error.empty(); }
+
+    void fail(std::string message) {
+        if (!failed()) error = std::move(message);
+    }
+
+    void failUnexpected() {
+        fail(Format("Parsing error in '%s': Unexpected %s.\n", input.data(), tokenType.find(getToken().type)->second.data()));
+    }
+
+    // Keeps track of how deep the stack gets, so evaluating never has to check
+    void emit(SigExprOpCode code, uintptr_t value = 0) {
+        if (code == SigExprOpCode::PushPtr || code == SigExprOpCode::PushConst) {
+            if (++depth > SigExpr::MaxStack) fail(Format("Parsing error in '%s': Expression is too deep.\n", input.data()));
+        } else if (code != SigExprOpCode::Deref) {
+            depth--;
+        }
+        program.push_back({ code, value });
+    }
+
+    void expression(bool allowComma = true) {
+        summand(false, allowComma);
+
+        SigExprToken token = getToken();
+        while (!failed() && (token.type == Plus || token.type == Minus)) {
+            nextToken();
+
+            summand(false, allowComma);
+            emit(token.type == Plus ? SigExprOpCode::Add : SigExprOpCode::Sub);
+            token = getToken();
+        }
+    }
+
+    void summand(bool onlyDereferable, bool allowComma = true) {
+        SigExprToken token = getToken();
+        nextToken();
+
+        switch (token.type) {
+            case Deref: {
+                summand(true, allowComma);
+                emit(SigExprOpCode::Deref);
+                return;
+            }
+            case LParen: {
+                expression();
+                token = getToken();
+                nextToken();
+
+                if (token.type == Comma && allowComma) {
+                    expression(false);
+                    emit(SigExprOpCode::Adrp);
+                    token = getToken();
+                    nextToken();
+                }
+
+                if (token.type != RParen) break;
+                return;
+            }
+            case Ptr: {
+                emit(SigExprOpCode::PushPtr);
+                return;
+            }
+            case Number: {
+                if (onlyDereferable) break;
+                emit(SigExprOpCode::PushConst, token.value);
+                return;
+            }
+            default:
+                break;
+        }
+
+        failUnexpected();
+    }
+
+  public:
+    SigExprCompiler(std::string_view input, const SigExprToken* tokens, std::vector<SigExprOp>& program, std::string& error)
+        : input(input), token(tokens), program(program), error(error) {}
+
+    bool compile() {
+        expression();
+        if (!failed() && getToken().type != End) failUnexpected();
+        return !failed();
+    }
+};
+
+bool SigExpr::Compile(std::string_view input, std::string& error) {
+    this->input = input;
+    program.clear();
+
+    std::vector<SigExprToken> tokens;
+    SigExprLexer lexer(input);
+    SigExprToken token;
+    do {
+        if (!lexer.nextToken(token, error)) return false;
+        tokens.push_back(token);
+    } while (token.type != End);
+
+    if (!SigExprCompiler(input, tokens.data(), program, error).compile()) {
+        program.clear();
+        return false;
+    }
+    return true;
+}
+
+bool SigExpr::Load(std::string_view input, std::span<const SigExprOp> program) {
+    this->input.clear();
+    this->program.clear();
+
+    size_t depth = 0;
+    for (const SigExprOp& op : program) {
+        switch (op.code) {
+            case SigExprOpCode::PushPtr:
+            case SigExprOpCode::PushConst:
+                if (++depth > MaxStack) return false;
+                break;
+            case SigExprOpCode::Deref:
+                if (depth < 1) return false;
+                break;
+            case SigExprOpCode::Add:
+            case SigExprOpCode::Sub:
+            case SigExprOpCode::Adrp:
+                if (depth-- < 2) return false;
+                break;
+            default:
+                return false;
+        }
+    }
+    if (!program.empty() && depth != 1) return false;
+
+    this->input = input;
+    this->program.assign(program.begin(), program.end());
+    return true;
+}
+
+bool SigExpr::Eval(uintptr_t ptr, SigExprReader read, uintptr_t& result, std::string& error) const {
+    uintptr_t stack[MaxStack];
+    size_t top = 0;
+
+    auto readMemory = [&]<typename T>(uintptr_t address, T& value) {
+        if (read(address, &value, sizeof(T))) return true;
+        error = Format("Evaluation error in '%s': Cannot read 0x%lx.\n", input.data(), address);
+        return false;
+    };
+
+    for (const SigExprOp& op : program) {
+        switch (op.code) {
+            case SigExprOpCode::PushPtr:
+                stack[top++] = ptr;
+                break;
+            case SigExprOpCode::PushConst:
+                stack[top++] = op.value;
+                break;
+            case SigExprOpCode::Add:
+                top--;
+                stack[top - 1] += stack[top];
+                break;
+            case SigExprOpCode::Sub:
+                top--;
+                stack[top - 1] -= stack[top];
+                break;
+            case SigExprOpCode::Deref: {
+                uint64_t value;
+                if (!readMemory(stack[top - 1], value)) return false;
+                stack[top - 1] = value;
+                break;
+            }
+            case SigExprOpCode::Adrp: {
+                top--;
+                uintptr_t address = stack[top - 1];
+                uint32_t adrp, ldr;
+                if (!readMemory(address, adrp) || !readMemory(address + stack[top], ldr)) return false;
+                stack[top - 1] = rd::mem::DecodePointer(address, adrp, ldr);
+                break;
+            }
+        }
+    }
+
+    result = stack[0];
+    return true;
+}
+
+}  // namespace hook
+}  // namespace rd
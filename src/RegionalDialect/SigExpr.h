@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace rd {
+namespace hook {
+
+    enum SigExprTokenType {
+        Start,
+        Plus,
+        Minus,
+        Deref,
+        LParen,
+        RParen,
+        Comma,
+        Number,
+        Ptr,
+        End
+    };
+
+    struct SigExprToken {
+        SigExprTokenType type;
+        uintptr_t value;
+    };
+
+    // Instructions of a compiled expression, each one works on the top of the stack
+    enum class SigExprOpCode : uint8_t {
+        PushPtr,    // The signature's match
+        PushConst,  // value
+        Add,
+        Sub,
+        Deref,      // Reads the 64-bit value at the address on top
+        Adrp,       // Pops offset and address, pushes what the ADRP at address and the load offset bytes after it refer to
+    };
+
+    struct SigExprOp {
+        SigExprOpCode code;
+        uintptr_t value;
+    };
+
+    // Reads size bytes at address, false if they aren't readable.
+    // Expressions read the module's own memory on the device and a dump of it in the host tools.
+    using SigExprReader = bool (*)(uintptr_t address, void* out, size_t size);
+
+    // A signature's "expr", compiled once with the signatures into a postfix program evaluated against the match
+    class SigExpr {
+      public:
+        static constexpr size_t MaxStack = 16;
+
+        // Fails with a message in error on a lexing or parsing error
+        bool Compile(std::string_view input, std::string& error);
+
+        // Takes a program Compile produced earlier, such as one stored in config.bin.
+        // False, leaving it empty, when the program would under or overflow the stack.
+        bool Load(std::string_view input, std::span<const SigExprOp> program);
+
+        bool Empty() const { return program.empty(); }
+        std::string_view Input() const { return input; }
+        std::span<const SigExprOp> Program() const { return program; }
+
+        // Fails with a message in error on an unreadable address
+        bool Eval(uintptr_t ptr, SigExprReader read, uintptr_t& result, std::string& error) const;
+
+      private:
+        std::string input;  // Kept for the log, outlives the config it came from
+        std::vector<SigExprOp> program;
+    };
+
+}  // namespace hook
+}  // namespace rd
@@ -0,0 +1,426 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+#include "Signature.h"
+#include "XRef.h"
+
+using namespace std;
+
+namespace rd {
+namespace hook {
+
+static bool CompilePattern(CompiledSignature& sig, const cJSON* text, string& error) {
+    CompiledPattern& compiled = sig.patterns.emplace_back();
+    compiled.text = cJSON_IsString(text) ? text->valuestring : "";
+    if (compiled.pattern.Compile(compiled.text)) return true;
+
+    error = "Malformed pattern '" + string(compiled.text) + "', expected hex bytes with ? for wildcards.\n";
+    return false;
+}
+
+static bool CompileInsns(CompiledSignature& sig, const cJSON* text, string& error) {
+    CompiledPattern& compiled = sig.patterns.emplace_back();
+    compiled.text = cJSON_IsString(text) ? text->valuestring : "";
+    if (compiled.pattern.CompileInsns(compiled.text)) return true;
+
+    error = "Malformed insns '" + string(compiled.text) + "', expected words such as 94000000/FC000000.\n";
+    return false;
+}
+
+// Numbers, or strings so they can be written in hex
+static bool ReadNumber(const cJSON* item, uintptr_t& out) {
+    if (cJSON_IsNumber(item)) {
+        out = static_cast<uintptr_t>(cJSON_GetNumberValue(item));
+        return true;
+    }
+    if (!cJSON_IsString(item)) return false;
+
+    char* end;
+    out = strtoull(item->valuestring, &end, 0);
+    return end != item->valuestring && *end == '\0';
+}
+
+// "Category/Name", or just "Name" in the signature's own category
+static void SplitName(const CompiledSignature& sig, string_view text, string_view& category, string_view& name) {
+    size_t slash = text.find('/');
+    category = slash == string_view::npos ? sig.category : text.substr(0, slash);
+    name = slash == string_view::npos ? text : text.substr(slash + 1);
+}
+
+static bool CompileScope(CompiledSignature& compiled, const cJSON* sig, string& error) {
+    SigScope& scope = compiled.scope;
+
+    if (const char* segment = cJSON_GetStringValue(cJSON_GetObjectItem(sig, "segment"))) {
+        string_view value = segment;
+        if (value == "text") scope.segment = SigSegment::Text;
+        else if (value == "rodata") scope.segment = SigSegment::Rodata;
+        else if (value == "data") scope.segment = SigSegment::Data;
+        else error = string("Unknown segment '") + segment + "'.\n";
+    }
+
+    if (const cJSON* window = cJSON_GetObjectItem(sig, "window")) {
+        if (cJSON_GetArraySize(window) != 2 || !ReadNumber(cJSON_GetArrayItem(window, 0), scope.windowStart) ||
+            !ReadNumber(cJSON_GetArrayItem(window, 1), scope.windowEnd) || scope.windowEnd <= scope.windowStart)
+            error = "The window must be [start, end].\n";
+    }
+
+    if (const char* nearName = cJSON_GetStringValue(cJSON_GetObjectItem(sig, "near"))) {
+        SplitName(compiled, nearName, scope.nearCategory, scope.nearName);
+
+        if (!ReadNumber(cJSON_GetObjectItem(sig, "within"), scope.within))
+            error = string("Near ") + nearName + " without saying within how many bytes.\n";
+    }
+
+    return error.empty();
+}
+
+static bool CompileXRef(CompiledSignature& compiled, const cJSON* xref, string& error) {
+    SigXRef& ref = compiled.xref;
+
+    if (const char* from = cJSON_GetStringValue(cJSON_GetObjectItem(xref, "from"))) {
+        ref.kind = SigXRef::Kind::From;
+        SplitName(compiled, from, ref.category, ref.name);
+
+        const cJSON* at = cJSON_GetObjectItem(xref, "at");
+        if (at && !ReadNumber(at, ref.value)) error = "The xref's \"at\" must be a number.\n";
+    } else if (const cJSON* to = cJSON_GetObjectItem(xref, "to")) {
+        ref.kind = SigXRef::Kind::To;
+        if (!ReadNumber(to, ref.value) && cJSON_IsString(to)) SplitName(compiled, to->valuestring, ref.category, ref.name);
+    } else {
+        error = "The xref needs either \"from\" or \"to\".\n";
+    }
+
+    return error.empty();
+}
+
+vector<CompiledSignature> CompileSignatures(const cJSON* signatures, vector<string>& errors) {
+    vector<CompiledSignature> ret;
+
+    const cJSON* category;
+    cJSON_ArrayForEach(category, signatures) {
+        const cJSON* sig;
+        cJSON_ArrayForEach(sig, category) {
+            CompiledSignature& compiled = ret.emplace_back();
+            compiled.category = category->string;
+            compiled.name = sig->string;
+
+            const cJSON* pattern = cJSON_GetObjectItem(sig, "pattern");
+            const cJSON* insns = cJSON_GetObjectItem(sig, "insns");
+            const cJSON* xref = cJSON_GetObjectItem(sig, "xref");
+
+            string error;
+            if (pattern || insns || xref) {
+                if (pattern) CompilePattern(compiled, pattern, error);
+                else if (insns) CompileInsns(compiled, insns, error);
+                else CompileXRef(compiled, xref, error);
+
+                if (const cJSON* offset = cJSON_GetObjectItem(sig, "offset"))
+                    compiled.offset = static_cast<size_t>(static_cast<int64_t>(cJSON_GetNumberValue(offset)));  // Negative ones wrap around
+                if (const cJSON* occurrence = cJSON_GetObjectItem(sig, "occurrence"))
+                    compiled.occurrence = static_cast<int>(cJSON_GetNumberValue(occurrence));
+
+                const char* expr = cJSON_GetStringValue(cJSON_GetObjectItem(sig, "expr"));
+                if (error.empty() && expr) compiled.expr.Compile(expr, error);
+                if (error.empty()) CompileScope(compiled, sig, error);
+            } else if (const cJSON* patterns = cJSON_GetObjectItem(sig, "patterns")) {
+                compiled.isArray = true;
+
+                const cJSON* pattern;
+                cJSON_ArrayForEach(pattern, patterns) {
+                    if (!CompilePattern(compiled, pattern, error)) break;
+                }
+            }
+
+            // A broken signature is left out, whatever uses it is then skipped like for a missing one
+            if (!error.empty()) {
+                errors.push_back("Signature " + string(compiled.category) + "/" + string(compiled.name) +
+                                 " is disabled: " + error);
+                ret.pop_back();
+            }
+        }
+    }
+
+    sort(ret.begin(), ret.end(), [](const CompiledSignature& a, const CompiledSignature& b) {
+        return pair(a.category, a.name) < pair(b.category, b.name);
+    });
+
+    return ret;
+}
+
+const CompiledSignature* FindSignature(span<const CompiledSignature> signatures, string_view category,
+                                       string_view name) {
+    auto it = lower_bound(signatures.begin(), signatures.end(), pair(category, name),
+                          [](const CompiledSignature& sig, pair<string_view, string_view> key) {
+                              return pair(sig.category, sig.name) < key;
+                          });
+
+    if (it == signatures.end() || it->category != category || it->name != name) return nullptr;
+    return &*it;
+}
+
+string_view StringPool::Intern(string_view text) {
+    auto it = index.find(text);
+    if (it != index.end()) return *it;
+
+    string_view interned = strings.emplace_back(text);
+    index.insert(interned);
+    return interned;
+}
+
+void InternStrings(span<CompiledSignature> signatures, StringPool& pool) {
+    for (CompiledSignature& sig : signatures) {
+        sig.category = pool.Intern(sig.category);
+        sig.name = pool.Intern(sig.name);
+        for (CompiledPattern& compiled : sig.patterns) compiled.text = pool.Intern(compiled.text);
+
+        sig.scope.nearCategory = pool.Intern(sig.scope.nearCategory);
+        sig.scope.nearName = pool.Intern(sig.scope.nearName);
+        sig.xref.category = pool.Intern(sig.xref.category);
+        sig.xref.name = pool.Intern(sig.xref.name);
+    }
+}
+
+void SignatureIndex::Build(span<const CompiledSignature> signatures) {
+    this->signatures = signatures;
+
+    size_t capacity = 16;
+    while (capacity < signatures.size() * 2) capacity *= 2;
+    slots.assign(capacity, {});
+
+    for (size_t i = 0; i < signatures.size(); i++) {
+        uint32_t hash = SigKey::Hash(signatures[i].category, signatures[i].name);
+        size_t slot = hash & (capacity - 1);
+        while (slots[slot].index != UINT32_MAX) slot = (slot + 1) & (capacity - 1);
+        slots[slot] = { hash, static_cast<uint32_t>(i) };
+    }
+}
+
+const CompiledSignature* SignatureIndex::Find(const SigKey& key) const {
+    if (slots.empty()) return nullptr;
+
+    size_t mask = slots.size() - 1;
+    for (size_t slot = key.hash & mask; slots[slot].index != UINT32_MAX; slot = (slot + 1) & mask) {
+        if (slots[slot].hash != key.hash) continue;
+
+        const CompiledSignature& sig = signatures[slots[slot].index];
+        if (sig.category == key.category && sig.name == key.name) return &sig;
+    }
+    return nullptr;
+}
+
+void AddToBatch(span<CompiledSignature> signatures, PatternSet& batch) {
+    for (CompiledSignature& sig : signatures) {
+        for (CompiledPattern& compiled : sig.patterns) {
+            if (sig.Deferred())
+                continue;
+            else if (sig.isArray)
+                compiled.batchId = batch.Add(compiled.pattern.view, PatternSet::AllMatches);
+            else if (sig.occurrence >= 0)
+                compiled.batchId = batch.Add(compiled.pattern.view, sig.occurrence + 1);
+        }
+    }
+}
+
+// Where a signature ends up once its expr is applied
+static bool Resolve(const CompiledSignature& sig, const PatternSet& batch, SigExprReader read, uintptr_t& result,
+                    string& error) {
+    uintptr_t match = ResolveMatch(sig, batch);
+    if (match == 0) {
+        error = "not found";
+        return false;
+    }
+
+    result = match;
+    return sig.expr.Empty() || sig.expr.Eval(match, read, result, error);
+}
+
+struct DeferredContext {
+    span<CompiledSignature> signatures;
+    const PatternSet& batch;
+    const ModuleLayout& module;
+    SigExprReader read;
+};
+
+static bool ResolveDeferred(CompiledSignature& sig, DeferredContext& context, string& error);
+
+// Where a signature that another one depends on ends up, resolving it first if it's deferred too
+static bool ResolveDependency(string_view category, string_view name, DeferredContext& context, uintptr_t& address,
+                              string& error) {
+    string fullName = string(category) + "/" + string(name);
+    auto it = lower_bound(context.signatures.begin(), context.signatures.end(), pair(category, name),
+                          [](const CompiledSignature& other, pair<string_view, string_view> key) {
+                              return pair(other.category, other.name) < key;
+                          });
+
+    if (it == context.signatures.end() || it->category != category || it->name != name || it->isArray)
+        error = fullName + ", which is missing";
+    else if (it->Deferred() && !ResolveDeferred(*it, context, error))
+        error = fullName + ", which " + (error.empty() ? "is not found" : error);
+    else if (!Resolve(*it, context.batch, context.read, address, error))
+        error = fullName + ", which is " + error;
+
+    return error.empty();
+}
+
+// The range a signature's scope limits it to, size is how far a match may run past the end of a near one
+static bool ScopeRange(const CompiledSignature& sig, DeferredContext& context, size_t size, uintptr_t& start,
+                       uintptr_t& end, string& error) {
+    const SigScope& scope = sig.scope;
+    const ModuleLayout& module = context.module;
+
+    start = module.textStart, end = module.textEnd;
+    if (scope.segment == SigSegment::Rodata) start = module.rodataStart, end = module.rodataEnd;
+    if (scope.segment == SigSegment::Data) start = module.dataStart, end = module.dataEnd;
+
+    if (scope.windowEnd != 0) {
+        start = max(start, module.base + scope.windowStart);
+        end = min(end, module.base + scope.windowEnd);
+    }
+
+    if (!scope.nearName.empty()) {
+        uintptr_t nearAddress;
+        if (!ResolveDependency(scope.nearCategory, scope.nearName, context, nearAddress, error)) {
+            error = "is near " + error;
+            return false;
+        }
+
+        start = max(start, nearAddress > scope.within ? nearAddress - scope.within : 0);
+        end = min(end, nearAddress + scope.within + size);
+    }
+
+    end = max(start, end);
+    return true;
+}
+
+static bool ResolveScope(CompiledSignature& sig, DeferredContext& context, string& error) {
+    const ModuleLayout& module = context.module;
+    if (!ScopeRange(sig, context, sig.patterns.front().pattern.view.size, sig.scanStart, sig.scanEnd, error))
+        return false;
+
+    if (sig.occurrence >= 0) {
+        PatternCursor cursor(sig.patterns.front().pattern.view, module.Pointer(sig.scanStart), module.Pointer(sig.scanEnd));
+        const uint8_t* match = cursor.Next();
+        for (int i = 0; i < sig.occurrence && match; i++) match = cursor.Next();
+
+        if (match) sig.deferredMatch = sig.scanStart + (match - module.Pointer(sig.scanStart)) + sig.offset;
+    }
+    return true;
+}
+
+static bool ResolveXRef(CompiledSignature& sig, DeferredContext& context, string& error) {
+    const SigXRef& ref = sig.xref;
+    const ModuleLayout& module = context.module;
+
+    uintptr_t address = module.base + ref.value;
+    if (!ref.name.empty()) {
+        if (!ResolveDependency(ref.category, ref.name, context, address, error)) {
+            error = (ref.kind == SigXRef::Kind::From ? "refers from " : "refers to ") + error;
+            return false;
+        }
+        if (ref.kind == SigXRef::Kind::From) address += ref.value;
+    }
+
+    // Targets outside the 4 GiB after .text are never pairs the module makes
+    auto inModule = [&](uintptr_t target) {
+        return target >= module.textStart && target - module.textStart <= UINT32_MAX;
+    };
+
+    if (ref.kind == SigXRef::Kind::From) {
+        // address is either the ADRP or the instruction completing it, at most XRefMaxDistance after the ADRP
+        if (address < module.textStart || address >= module.textEnd) return true;
+        constexpr uintptr_t reach = rd::mem::XRefMaxDistance * 4;
+        uintptr_t start = address - min(address - module.textStart, reach);
+        start -= (start - module.textStart) & 3;
+        uintptr_t end = min(module.textEnd, address + reach + 4);
+
+        // An ADRP at address wins over an instruction completing another one, and its first completion over the rest
+        uintptr_t fromAdrp = 0, fromUse = 0;
+        rd::mem::ForEachXRef(module.Pointer(start), module.Pointer(end), start,
+                             [&](uintptr_t adrp, uintptr_t use, uintptr_t target) {
+                                 if (!inModule(target)) return true;
+                                 if (adrp == address) {
+                                     fromAdrp = target;
+                                     return false;
+                                 }
+                                 if (use == address) fromUse = target;
+                                 return true;
+                             });
+
+        if (uintptr_t target = fromAdrp ? fromAdrp : fromUse) sig.deferredMatch = target + sig.offset;
+        return true;
+    }
+
+    uintptr_t start, end;
+    if (!ScopeRange(sig, context, 0, start, end, error)) return false;
+    start = max(start, module.textStart);
+    start -= (start - module.textStart) & 3;
+    end = max(start, min(end, module.textEnd));
+
+    if (inModule(address)) {
+        rd::mem::ForEachXRef(module.Pointer(start), module.Pointer(end), start,
+                             [&](uintptr_t adrp, uintptr_t, uintptr_t target) {
+                                 if (target == address) sig.deferredMatches.push_back(adrp);
+                                 return true;
+                             });
+    }
+
+    if (sig.occurrence >= 0 && static_cast<size_t>(sig.occurrence) < sig.deferredMatches.size())
+        sig.deferredMatch = sig.deferredMatches[sig.occurrence] + sig.offset;
+    return true;
+}
+
+static bool ResolveDeferred(CompiledSignature& sig, DeferredContext& context, string& error) {
+    using enum CompiledSignature::DeferredState;
+
+    if (sig.deferredState == Resolved) return sig.deferredMatch != 0;
+    if (sig.deferredState == Resolving) {
+        error = "is part of a cycle of signatures depending on each other";
+        return false;
+    }
+
+    sig.deferredState = Resolving;
+    bool resolved = sig.xref.kind != SigXRef::Kind::None ? ResolveXRef(sig, context, error)
+                                                          : ResolveScope(sig, context, error);
+    sig.deferredState = Resolved;
+
+    return resolved && sig.deferredMatch != 0;
+}
+
+void ResolveDeferred(span<CompiledSignature> signatures, const PatternSet& batch, const ModuleLayout& module,
+                     SigExprReader read, vector<string>& errors) {
+    DeferredContext context = { signatures, batch, module, read };
+
+    for (CompiledSignature& sig : signatures) {
+        if (!sig.Deferred() || sig.isArray) continue;
+
+        string error;
+        if (!ResolveDeferred(sig, context, error) && !error.empty())
+            errors.push_back("Signature " + string(sig.category) + "/" + string(sig.name) + " " + error + "\n");
+    }
+}
+
+uintptr_t ResolveMatch(const CompiledSignature& sig, const PatternSet& batch) {
+    if (sig.Deferred()) return sig.deferredMatch;
+    if (sig.patterns.empty()) return 0;
+
+    const CompiledPattern& compiled = sig.patterns.front();
+    if (compiled.batchId == SIZE_MAX) return 0;
+
+    auto matches = batch.Matches(compiled.batchId);
+    if (static_cast<size_t>(sig.occurrence) >= matches.size()) return 0;
+    return matches[sig.occurrence] + sig.offset;
+}
+
+int PrecomputedMatchSymbol(char* out, size_t size, const CompiledSignature& sig, size_t pattern, size_t index) {
+    int length = snprintf(out, size, "%.*s/%.*s[%zu]#", (int)sig.category.size(), sig.category.data(),
+                          (int)sig.name.size(), sig.name.data(), pattern);
+    if (length < 0 || (size_t)length >= size) return length;
+
+    int suffix = index == SIZE_MAX ? snprintf(out + length, size - length, "n")
+                                   : snprintf(out + length, size - length, "%zu", index);
+    return suffix < 0 ? suffix : length + suffix;
+}
+
+}  // namespace hook
+}  // namespace rd
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <deque>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+#include <cJSON/cJSON.h>
+
+#include "Pattern.h"
+#include "SigExpr.h"
+
+namespace rd {
+namespace hook {
+
+    enum class SigSegment { Text, Rodata, Data };
+
+    // Where a signature is looked for, the whole of .text unless the gamedef narrows it down with
+    // "segment": "text" | "rodata" | "data"
+    // "window": [start, end], module-relative
+    // "near": "Category/Name" (or just "Name" in the same category), "within": N bytes either side of its result
+    // Numbers can also be written as strings, so they can be in hex.
+    struct SigScope {
+        SigSegment segment = SigSegment::Text;
+        uintptr_t windowStart = 0;
+        uintptr_t windowEnd = 0;  // No window when 0
+        std::string_view nearCategory;
+        std::string_view nearName;  // Not near anything when empty
+        size_t within = 0;
+
+        bool IsDefault() const { return segment == SigSegment::Text && windowEnd == 0 && nearName.empty(); }
+    };
+
+    // A signature found through the ADRP pairs in .text instead of a pattern:
+    // "xref": { "from": "Category/Name", "at": N } is the address the pair N bytes into that signature's result refers to
+    // "xref": { "to": "Category/Name" | address } are the ADRPs of every pair referring to that signature's result,
+    // or to a module-relative address, "occurrence" picks one. A "window" or "near" limits where they're looked for,
+    // say to the function referring to it, instead of the whole of .text.
+    struct SigXRef {
+        enum class Kind { None, From, To } kind = Kind::None;
+        std::string_view category;
+        std::string_view name;  // Empty for an address
+        uintptr_t value = 0;    // "at", or the address
+    };
+
+    // The main module's segments as addresses, and where the module can be read from in this process
+    struct ModuleLayout {
+        const uint8_t* memory;  // Where base is mapped
+        uintptr_t base;         // Start of the module, what windows are relative to
+        uintptr_t textStart, textEnd;
+        uintptr_t rodataStart, rodataEnd;
+        uintptr_t dataStart, dataEnd;
+
+        const uint8_t* Pointer(uintptr_t address) const { return memory + (address - base); }
+    };
+
+    struct CompiledPattern {
+        std::string_view text;  // Kept for the log
+        Pattern pattern;
+        size_t batchId = SIZE_MAX;
+    };
+
+    // A gamedef signature with everything SigScan needs, compiled once when the config loads
+    struct CompiledSignature {
+        std::string_view category;
+        std::string_view name;
+        std::vector<CompiledPattern> patterns;  // The one "pattern" or "insns", or every entry of "patterns"
+        bool isArray = false;
+        size_t offset = 0;
+        int occurrence = 0;
+        SigExpr expr;
+
+        SigScope scope;
+        SigXRef xref;
+
+        // Scoped and xref signatures are resolved once the batch is done, see ResolveDeferred
+        bool Deferred() const { return !scope.IsDefault() || xref.kind != SigXRef::Kind::None; }
+
+        enum class DeferredState { Unresolved, Resolving, Resolved } deferredState = DeferredState::Unresolved;
+        uintptr_t scanStart = 0;  // Where a scoped signature was looked for
+        uintptr_t scanEnd = 0;
+        uintptr_t deferredMatch = 0;
+        std::vector<uintptr_t> deferredMatches;  // Every match before the offset, for xrefs to an address
+    };
+
+    // Compiles every signature under the gamedef's "signatures", sorted by category and name.
+    // Names and pattern text are referenced, not copied, so the cJSON tree must outlive them.
+    // Signatures that don't compile are left out, with the reason in errors.
+    std::vector<CompiledSignature> CompileSignatures(const cJSON* signatures, std::vector<std::string>& errors);
+
+    const CompiledSignature* FindSignature(std::span<const CompiledSignature> signatures, std::string_view category,
+                                           std::string_view name);
+
+    // Owns copies of the strings compiled signatures point at, so they can outlive their cJSON tree
+    class StringPool {
+      public:
+        // Null-terminated, and the same view for the same text
+        std::string_view Intern(std::string_view text);
+
+      private:
+        std::deque<std::string> strings;  // Never moves what it holds
+        std::unordered_set<std::string_view> index;
+    };
+
+    // Points every string the signatures reference into pool instead of the tree they were compiled from
+    void InternStrings(std::span<CompiledSignature> signatures, StringPool& pool);
+
+    // A signature's category and name with their FNV-1a hash, worked out at compile time for literals
+    struct SigKey {
+        std::string_view category;
+        std::string_view name;
+        uint32_t hash;
+
+        static constexpr uint32_t Hash(std::string_view category, std::string_view name) {
+            uint32_t hash = 0x811C9DC5;
+            for (char ch : category) hash = (hash ^ (uint8_t)ch) * 0x01000193;
+            hash = (hash ^ '/') * 0x01000193;
+            for (char ch : name) hash = (hash ^ (uint8_t)ch) * 0x01000193;
+            return hash;
+        }
+
+        constexpr SigKey(std::string_view category, std::string_view name)
+            : category(category), name(name), hash(Hash(category, name)) {}
+    };
+
+    consteval SigKey MakeSigKey(std::string_view category, std::string_view name) {
+        return SigKey(category, name);
+    }
+
+    // Open-addressing table from keys to signatures, finding one costs a hash comparison or two and no string building
+    class SignatureIndex {
+      public:
+        // The signatures must stay where they are for as long as the index is used
+        void Build(std::span<const CompiledSignature> signatures);
+
+        const CompiledSignature* Find(const SigKey& key) const;
+
+      private:
+        struct Slot {
+            uint32_t hash = 0;
+            uint32_t index = UINT32_MAX;  // Empty when UINT32_MAX
+        };
+
+        std::span<const CompiledSignature> signatures;
+        std::vector<Slot> slots;  // Power of two, at most half full
+    };
+
+    // Adds every pattern to the batch, keeping as many matches as its signature needs.
+    // Deferred signatures are left out, ResolveDeferred looks for them on their own.
+    void AddToBatch(std::span<CompiledSignature> signatures, PatternSet& batch);
+
+    // Looks for every scoped signature within its scope and every xref among the ADRP pairs around it, after the
+    // signatures they depend on. Call once the batch has its results, failures leave the signature without a match.
+    void ResolveDeferred(std::span<CompiledSignature> signatures, const PatternSet& batch, const ModuleLayout& module,
+                         SigExprReader read, std::vector<std::string>& errors);
+
+    // Where SigScan finds a signature before its expr is applied, 0 if there's no such match
+    uintptr_t ResolveMatch(const CompiledSignature& sig, const PatternSet& batch);
+
+    // Known builds' offset tables also list every match of each of a signature's patterns, the way SigScanExhaust
+    // and SigScanArray return them, so those don't scan either. Lists longer than this are left to be scanned for.
+    inline constexpr size_t MaxPrecomputedMatches = 256;
+
+    // Writes the table symbol of a list's count, "Category/Name[pattern]#n", or of its index-th match,
+    // "Category/Name[pattern]#index". Returns its length like snprintf.
+    int PrecomputedMatchSymbol(char* out, size_t size, const CompiledSignature& sig, size_t pattern,
+                               size_t index = SIZE_MAX);
+
+}  // namespace hook
+}  // namespace rd
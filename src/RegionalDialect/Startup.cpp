@@ -0,0 +1,102 @@
+#include <atomic>
+
+#include <lib.hpp>
+#include <log/logger_mgr.hpp>
+#include <nn/os.hpp>
+
+#include "Config.h"
+#include "Feature.h"
+#include "Hook.h"
+#include "Reload.h"
+#include "Startup.h"
+#include "Trace.h"
+
+namespace rd {
+namespace startup {
+
+enum class State { Idle, Resolving, Committing, Committed };
+
+static std::atomic<State> s_State = State::Idle;
+static std::string s_RomMount;
+
+// Set on the worker and on the committing thread, so whatever they call Commit through passes straight through
+static thread_local bool t_InStartup = false;
+
+// Parsing and scanning keep plenty of their state on the heap, but cJSON recurses
+static constexpr size_t WorkerStackSize = 0x20000;
+alignas(nn::os::ThreadStackAlignment) static uint8_t s_WorkerStack[WorkerStackSize];
+static nn::os::ThreadType s_Worker;
+static bool s_WorkerStarted = false;
+
+static void Resolve(void*) {
+    t_InStartup = true;
+    trace::Span span("init", "resolve");
+
+    {
+        trace::Span span("init", "config");
+        rd::config::Init(s_RomMount);
+    }
+    Logging.Log("[RegionalDialect] Finished config init.\n");
+
+    // Features that are off don't get their signatures scanned for
+    rd::feature::Select();
+    {
+        trace::Span span("init", "signatures");
+        rd::hook::Init(rd::feature::UnusedSignatures());
+    }
+    Logging.Log("[RegionalDialect] Finished signature scan.\n");
+
+    t_InStartup = false;
+}
+
+void Begin(std::string romMount) {
+    s_RomMount = std::move(romMount);
+    s_State = State::Resolving;
+
+    // Off the game's main thread on core 0, the scan's helpers take the cores after this one
+    Result rc = nn::os::CreateThread(&s_Worker, Resolve, nullptr, s_WorkerStack, WorkerStackSize,
+                                     nn::os::DefaultThreadPriority, 1);
+    if (R_FAILED(rc)) {
+        Logging.Log("[RegionalDialect] Failed to create the startup thread, resolving now: 0x%x\n", rc);
+        Resolve(nullptr);
+        return;
+    }
+
+    nn::os::SetThreadNamePointer(&s_Worker, "RegionalDialect");
+    nn::os::StartThread(&s_Worker);
+    s_WorkerStarted = true;
+}
+
+void Commit() {
+    if (t_InStartup) return;
+
+    State expected = State::Resolving;
+    if (!s_State.compare_exchange_strong(expected, State::Committing)) {
+        while (s_State == State::Committing) nn::os::SleepThread(nn::TimeSpan::FromMilliSeconds(1));
+        return;
+    }
+
+    t_InStartup = true;
+    {
+        trace::Span init("init", "commit");
+        if (s_WorkerStarted) {
+            trace::Span span("init", "wait for resolve");
+            nn::os::WaitThread(&s_Worker);
+            nn::os::DestroyThread(&s_Worker);
+        }
+
+        // Nothing is hooked until the batch ends, no feature calls into what it hooks while initializing
+        rd::hook::HookBatch hooks;
+        rd::feature::Init({ .romMount = s_RomMount });
+    }
+    Logging.Log("[RegionalDialect] Finished initialization.\n");
+    trace::Save();
+
+    t_InStartup = false;
+    s_State = State::Committed;
+
+    rd::reload::Start(s_RomMount);
+}
+
+}  // namespace startup
+}  // namespace rd
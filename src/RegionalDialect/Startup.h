@@ -0,0 +1,20 @@
+#pragma once
+
+#include <string>
+
+namespace rd {
+namespace startup {
+
+    // Parses the config and resolves every signature on a worker thread, while the game keeps booting.
+    // Falls back to doing it on the calling thread if the worker can't be created.
+    void Begin(std::string romMount);
+
+    // Barrier between the two stages: waits for the worker, then installs the hooks and applies the patches.
+    // Only the first call does the work, other threads calling in the meantime wait until it's done,
+    // and calls from within either stage (files they open, for instance) return straight away.
+    // Features aren't ready one by one: every signature comes out of the same batch scan, and the text
+    // hooks are needed before the first file the game opens, so that's where everything waits.
+    void Commit();
+
+}  // namespace startup
+}  // namespace rd
@@ -178,67 +178,92 @@ bool ChkViewDic::Callback(uint param_1, uint param_2) {
     return Orig(param_1, param_2);
 }
 
-void Init() {
-    HOOK_VAR(game, ScrWork);
-    HOOK_VAR(game, OPTmenuModePtr);
-    HOOK_VAR(game, OPTmenuCur);
-    HOOK_VAR(game, OPTmenuPagePtr);
-    HOOK_VAR(game, PADcustom);
-    HOOK_VAR(game, PADrefPtr);
-    HOOK_VAR(game, PADonePtr);
-    HOOK_VAR(game, SYSSEvolPtr);
+static void InitSystem(const feature::Context&) {
+    rd::mem::PatchBatch patches;
 
-    if (rd::config::config["gamedef"]["signatures"]["game"].has("SaveMenuGuide")) {
-        uint32_t *SaveMenuGuide = (uint32_t*)rd::hook::SigScan("game", "SaveMenuGuide");
+    if (HAS_SIG(game, SaveMenuGuide)) {
+        uint32_t *SaveMenuGuide = (uint32_t*)rd::hook::SigScan({ "game", "SaveMenuGuide" });
         uint32_t buttonIds[] = { 0, 10010, 2, 10020, 6, 7, 10100, 1, 10000, 255 };
         ::memcpy(&SaveMenuGuide[6 * 20], buttonIds, sizeof(buttonIds));
     }
 
-    if (rd::config::config["gamedef"]["signatures"]["game"].has("audioLoweringAddr")) {
-        uintptr_t audioLoweringAddr = rd::hook::SigScan("game", "audioLoweringAddr");
+    if (HAS_SIG(game, audioLoweringAddr)) {
+        uintptr_t audioLoweringAddr = rd::hook::SigScan({ "game", "audioLoweringAddr" });
         uint32_t nop = inst::Nop().Value();
 
-        rd::mem::Overwrite(audioLoweringAddr,     nop);
-        rd::mem::Overwrite(audioLoweringAddr + 4, nop);
+        patches.Overwrite(audioLoweringAddr,     nop);
+        patches.Overwrite(audioLoweringAddr + 4, nop);
     }
 
     
-    if (rd::config::config["gamedef"]["signatures"]["game"].has("SkipModeFix"))
-        rd::mem::Overwrite(rd::hook::SigScan("game", "SkipModeFix"), inst::Branch(-284).Value());
+    if (HAS_SIG(game, SkipModeFix))
+        patches.Overwrite(rd::hook::SigScan({ "game", "SkipModeFix" }), inst::Branch(-284).Value());
 
-    if (rd::config::config["gamedef"]["signatures"]["game"].has("DoZSelection1"))
-        rd::mem::Overwrite(rd::hook::SigScan("game", "DoZSelection1"), inst::Branch(-796).Value());
+    if (HAS_SIG(game, DoZSelection1))
+        patches.Overwrite(rd::hook::SigScan({ "game", "DoZSelection1" }), inst::Branch(-796).Value());
 
-    if (rd::config::config["gamedef"]["signatures"]["game"].has("DoZSelection2"))
-        rd::mem::Overwrite(rd::hook::SigScan("game", "DoZSelection2"), inst::Branch(-320).Value());
+    if (HAS_SIG(game, DoZSelection2))
+        patches.Overwrite(rd::hook::SigScan({ "game", "DoZSelection2" }), inst::Branch(-320).Value());
     
-    if (rd::config::config["gamedef"]["signatures"]["game"].has("ShortcutMenuFix"))
-        rd::mem::Overwrite(rd::hook::SigScan("game", "ShortcutMenuFix"), inst::Movz(reg::W0, 0x370).Value());
+    if (HAS_SIG(game, ShortcutMenuFix))
+        patches.Overwrite(rd::hook::SigScan({ "game", "ShortcutMenuFix" }), inst::Movz(reg::W0, 0x370).Value());
 
     HOOK_FUNC(game, GSLflatRectF);
-    HOOK_FUNC(game, SetFlag);
+    BIND_FUNC(game, SetFlag);
     HOOK_FUNC(game, GetFlag);
+}
 
-    if (rd::config::config["patchdef"]["base"]["addNametags"].get<bool>()) {
-     
-        if (rd::config::config["gamedef"]["signatures"]["game"].has("OPTmenuMaxCur")) {
-            uint8_t *OPTmenuMaxCur = (uint8_t*)rd::hook::SigScan("game", "OPTmenuMaxCur");
-            OPTmenuMaxCur[4] = 4;
-        }
+static void InitScriptWork(const feature::Context&) {
+    HOOK_VAR(game, ScrWork);
+}
 
-        NametagOptionLayout = NametagOptionLayoutFromString(
-            rd::config::config["patchdef"]["base"]["nametagOptionLayout"].get<std::string_view>()
-        );
+static void InitDictionary(const feature::Context&) {
+    BIND_FUNC(game, ChkViewDic);
+}
 
-        HOOK_FUNC(game, SpeakerDrawingFunction);
-        HOOK_FUNC(game, OptionDispChip2);
-        HOOK_FUNC(game, OptionMain);
-        HOOK_FUNC(game, OptionDefault);
+static void InitNametagOption(const feature::Context&) {
+    HOOK_VAR(game, OPTmenuModePtr);
+    HOOK_VAR(game, OPTmenuCur);
+    HOOK_VAR(game, OPTmenuPagePtr);
+    HOOK_VAR(game, PADcustom);
+    HOOK_VAR(game, PADrefPtr);
+    HOOK_VAR(game, PADonePtr);
+    HOOK_VAR(game, SYSSEvolPtr);
+
+    if (HAS_SIG(game, OPTmenuMaxCur)) {
+        uint8_t *OPTmenuMaxCur = (uint8_t*)rd::hook::SigScan({ "game", "OPTmenuMaxCur" });
+        OPTmenuMaxCur[4] = 4;
     }
 
-    HOOK_FUNC(game, SSEvolume);
-    HOOK_FUNC(game, SSEplay);
-    HOOK_FUNC(game, ChkViewDic);
+    NametagOptionLayout = NametagOptionLayoutFromString(
+        rd::config::config.patchdef.nametagOptionLayout
+    );
+
+    BIND_FUNC(game, SSEvolume);
+    BIND_FUNC(game, SSEplay);
+
+    HOOK_FUNC(game, SpeakerDrawingFunction);
+    HOOK_FUNC(game, OptionDispChip2);
+    HOOK_FUNC(game, OptionMain);
+    HOOK_FUNC(game, OptionDefault);
+}
+
+static constexpr feature::Module SysModules[] = {
+    { "system", feature::Activation::Always, nullptr, nullptr,
+      "game/SaveMenuGuide game/audioLoweringAddr game/SkipModeFix game/DoZSelection1 game/DoZSelection2 "
+      "game/ShortcutMenuFix game/GSLflatRectF game/SetFlag game/GetFlag",
+      InitSystem },
+    { "scriptWork", feature::Activation::Required, nullptr, nullptr, "game/ScrWork", InitScriptWork },
+    { "dictionary", feature::Activation::Required, nullptr, nullptr, "game/ChkViewDic", InitDictionary },
+    { "nametagOption", feature::Activation::Option, &rd::config::Patchdef::addNametags, "system",
+      "game/OPTmenuModePtr game/OPTmenuCur game/OPTmenuPagePtr game/PADcustom game/PADrefPtr game/PADonePtr "
+      "game/SYSSEvolPtr game/OPTmenuMaxCur game/SSEvolume game/SSEplay game/SpeakerDrawingFunction "
+      "game/OptionDispChip2 game/OptionMain game/OptionDefault",
+      InitNametagOption },
+};
+
+std::span<const feature::Module> Modules() {
+    return SysModules;
 }
 
 }  // namespace sys
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "Feature.h"
 #include "Hook.h"
 
 namespace rd {
@@ -19,7 +20,7 @@ DECLARE_HOOK(GSLflatRectF, void,
             float spriteWidth, float spriteHeight, float displayX,
             float displayY, int color, int opacity, int unk);
 
-DECLARE_HOOK(SetFlag, void, uint flag, uint setValue);
+DECLARE_FUNC(SetFlag, void, uint flag, uint setValue);
 
 DECLARE_HOOK(GetFlag, bool, uint flag);
 
@@ -31,15 +32,15 @@ DECLARE_HOOK(OptionDispChip2, void, uint param_1);
 
 DECLARE_HOOK(OptionMain, void, void);
 
-DECLARE_HOOK(SSEvolume, void, uint param_1);
+DECLARE_FUNC(SSEvolume, void, uint param_1);
 
-DECLARE_HOOK(SSEplay, void, int param_1, int param_2);
+DECLARE_FUNC(SSEplay, void, int param_1, int param_2);
 
-DECLARE_HOOK(ChkViewDic, bool, uint param_1, uint param_2);
+DECLARE_FUNC(ChkViewDic, bool, uint param_1, uint param_2);
 
 DECLARE_HOOK(OptionDefault, void, void);
 
-void Init();
+std::span<const feature::Module> Modules();
 
 }  // namespace sys
 }  // namespace rd
\ No newline at end of file
@@ -88,9 +88,8 @@ struct StringTokenType {
     };
 };
 
-static float AtlasDialogueMargin = 0.0f;
-static float AtlasOutlineMargin = 0.0f;
-static float DialogueOutlineOffset = 0.0f;
+// Needs the MEStvramDrawEx hook, so it only changes with a restart. The margins are read from
+// rd::config::Live() as each glyph is drawn.
 static bool OutlinedFont = false;
 
 static int CurrentShadowFont = DIALOGUE_FONT_SURFACE_ID;
@@ -100,6 +99,7 @@ static bool NametagImplementation = false;
 static bool AddBacklogOutline = false;
 
 void transformFontAtlasCoordinates(
+    const rd::config::Patchdef& settings,
     int &fontSurfaceId, uint &color,
     float& uv_x, float& uv_y, float& uv_w, float& uv_h,
     float& pos_x0, float& pos_y0, float& pos_x1, float& pos_y1
@@ -113,10 +113,10 @@ void transformFontAtlasCoordinates(
 
     switch (fontSurfaceId) {
         case DIALOGUE_FONT_SURFACE_ID:
-            margin = AtlasDialogueMargin;
+            margin = settings.atlasDialogueMargin;
             break;
         case OUTLINE_FONT_SURFACE_ID:
-            margin = OutlinedFont ? AtlasOutlineMargin : AtlasDialogueMargin;
+            margin = OutlinedFont ? settings.atlasOutlineMargin : settings.atlasDialogueMargin;
             break;
         default:
             UNREACHABLE;
@@ -127,7 +127,7 @@ void transformFontAtlasCoordinates(
     if (OutlinedFont && fontSurfaceId == OUTLINE_FONT_SURFACE_ID) {
         for (const auto &coord : std::to_array<std::reference_wrapper<float>>(
             { pos_x0, pos_x1, pos_y0, pos_y1 }))
-            coord.get() += DialogueOutlineOffset;
+            coord.get() += settings.dialogueOutlineOffset;
     }  
 
     const float size = 48.0f;
@@ -331,8 +331,9 @@ int GSLfontStretchF::Callback(
     float pos_x0, float pos_y0, float pos_x1, float pos_y1,
     uint color, int opacity, bool shrink
 ) {
+    const auto& settings = rd::config::Live();
 
-    if (NametagImplementation &&
+    if (NametagImplementation && settings.addNametags &&
         fontSurfaceId == DIALOGUE_FONT_SURFACE_ID &&
         (pos_y0 == 760.5f || pos_y0 == 757.5f)) {
         if (!rd::sys::GetFlag::Callback(801)) return 0;
@@ -341,7 +342,7 @@ int GSLfontStretchF::Callback(
     }
 
     transformFontAtlasCoordinates(
-        fontSurfaceId, color,
+        settings, fontSurfaceId, color,
         uv_x, uv_y, uv_w, uv_h,
         pos_x0, pos_y0, pos_x1, pos_y1
     );
@@ -360,14 +361,15 @@ int GSLfontStretchWithMaskF::Callback(
     float pos_x0, float pos_y0, float pos_x1, float pos_y1,
     uint color, int opacity
 ) {
-    
+    const auto& settings = rd::config::Live();
+
     transformFontAtlasCoordinates(
-        fontSurfaceId, color,
+        settings, fontSurfaceId, color,
         uv_x, uv_y, uv_w, uv_h,
         pos_x0, pos_y0, pos_x1, pos_y1
     );
 
-    if (AddBacklogOutline && fontSurfaceId == DIALOGUE_FONT_SURFACE_ID && maskSurfaceId == 155) {
+    if (AddBacklogOutline && settings.addBacklogOutline && fontSurfaceId == DIALOGUE_FONT_SURFACE_ID && maskSurfaceId == 155) {
         static float offset = 1.5f;
         Orig(
             fontSurfaceId, maskSurfaceId,
@@ -394,8 +396,10 @@ int GSLfontStretchWithMaskExF::Callback(
     float pos_x0, float pos_y0, float pos_x1, float pos_y1,
     uint color, int opacity
 ) {
+    const auto& settings = rd::config::Live();
+
     transformFontAtlasCoordinates(
-        fontSurfaceId, color,
+        settings, fontSurfaceId, color,
         uv_x, uv_y, uv_w, uv_h,
         pos_x0, pos_y0, pos_x1, pos_y1
     );
@@ -413,21 +417,29 @@ void TipsDataInit::Callback(ulong thread, unsigned short *addr1, unsigned short
     // Running hooked function to populate EPmax
     Orig(thread, addr1, addr2);
 
-    uintptr_t SystemMenuDispAddr = rd::hook::SigScan("game", "SystemMenuDisp");
+    // The comparisons only need patching again when EPmax changes
+    static uint32_t patchedEPmax = UINT32_MAX;
+    if (*EPmaxPtr == patchedEPmax) return;
+    patchedEPmax = *EPmaxPtr;
 
-    // Get address of first comparison to patch
-    const uintptr_t patchInCmp1Addr = SystemMenuDispAddr - 0x1530;
+    // Get address of first comparison to patch, gamedefs can find it near SystemMenuDisp with a scoped signature
+    static const uintptr_t patchInCmp1Addr = [] {
+        if (HAS_SIG(game, TipsEPmaxCmp))
+            return rd::hook::SigScan({ "game", "TipsEPmaxCmp" });
+        return rd::hook::SigScan({ "game", "SystemMenuDisp" }) - 0x1530;
+    }();
 
     // Patching the comparison with the actual EPmax instead of hardcoded value
     // EPmax - 5 because of repeated TIPs
-    rd::mem::Overwrite(patchInCmp1Addr,       inst::CmpImmediate(reg::W9, *EPmaxPtr - 5).Value());
-    rd::mem::Overwrite(patchInCmp1Addr + 4,   inst::Movz(reg::W8, *EPmaxPtr - 5).Value());
+    rd::mem::PatchBatch patches;
+    patches.Overwrite(patchInCmp1Addr,       inst::CmpImmediate(reg::W9, *EPmaxPtr - 5).Value());
+    patches.Overwrite(patchInCmp1Addr + 4,   inst::Movz(reg::W8, *EPmaxPtr - 5).Value());
     
     // Same for the second comparison, although with different order and registers
     const uintptr_t patchInCmp2Addr = patchInCmp1Addr + 0x300;
         
-    rd::mem::Overwrite(patchInCmp2Addr,       inst::Movz(reg::W9, *EPmaxPtr - 5).Value());
-    rd::mem::Overwrite(patchInCmp2Addr + 8,   inst::CmpImmediate(reg::W8, *EPmaxPtr - 5).Value());
+    patches.Overwrite(patchInCmp2Addr,       inst::Movz(reg::W9, *EPmaxPtr - 5).Value());
+    patches.Overwrite(patchInCmp2Addr + 8,   inst::CmpImmediate(reg::W8, *EPmaxPtr - 5).Value());
 }
 
 void MESsetNGflag::Callback(bool nameNewline, bool rubyEnabled) {
@@ -675,17 +687,18 @@ void MEStvramDrawEx::Callback(int param_1, ulong param_2, int param_3, int param
     CurrentShadowFont = DIALOGUE_FONT_SURFACE_ID;
 }
 
-void Init(std::string const &romMount) {
+static void InitWidths(const feature::Context& context) {
     Result rc = 0;
-    rc = skyline::utils::readFile(romMount + "system/widths.bin", 0, &ourTable[0], 8000);
+    rc = skyline::utils::readFile(std::string(context.romMount) + "system/widths.bin", 0, &ourTable[0], WidthTableSize);
     if (R_SUCCEEDED(rc)) {
         Logging.Log("Successfully loaded widths\n");
     } else {
         Logging.Log("Failed to load widths: 0x%x\n", rc);
     }
+}
 
+static void InitText(const feature::Context&) {
     HOOK_VAR(game, MesNameDispLen);
-    HOOK_VAR(game, EPmaxPtr);
     HOOK_VAR(game, MEStextDatNumPtr);
     HOOK_VAR(game, MESngFontListTopNumPtr);
     HOOK_VAR(game, MESngFontListLastNumPtr);
@@ -693,81 +706,113 @@ void Init(std::string const &romMount) {
     HOOK_VAR(game, MEStext);
     HOOK_VAR(game, MESngFontListLast);
     HOOK_VAR(game, MESngFontListTop);
-    HOOK_VAR(game, MesFontColor);
-    HOOK_VAR(game, MESrevLineBufUsePtr);
-    HOOK_VAR(game, MESrevDispLinePos);
-    HOOK_VAR(game, MESrevLineBufp);
-    HOOK_VAR(game, MESrevText);
-    HOOK_VAR(game, MESrevDispLinePosY);
-    HOOK_VAR(game, MESrevTextSize);
-    HOOK_VAR(game, MESrevTextPos);
-    HOOK_VAR(game, MESrevDispPosPtr);
-    HOOK_VAR(game, MESrevDispMaxPtr);
 
-    if (rd::config::config["patchdef"]["base"]["hookText"].get<bool>()) {
-        uintptr_t englishOnlyOffsetTable = rd::hook::SigScan("game", "englishOnlyOffsetTable");
-        if (englishOnlyOffsetTable != 0 && *(uint32_t*)englishOnlyOffsetTable != 0xFFFFFF00)
-            ::memset(reinterpret_cast<void*>(englishOnlyOffsetTable), 0, 640);
+    uintptr_t englishOnlyOffsetTable = rd::hook::SigScan({ "game", "englishOnlyOffsetTable" });
+    if (englishOnlyOffsetTable != 0 && *(uint32_t*)englishOnlyOffsetTable != 0xFFFFFF00)
+        ::memset(reinterpret_cast<void*>(englishOnlyOffsetTable), 0, 640);
 
-        if (rd::config::config["gamedef"]["signatures"]["game"].has("widthCheck")) {
-            uint32_t branchFix = 0x3A5F43E8; 
-            for (uintptr_t widthCheck : rd::hook::SigScanArray("game", "widthCheck", true))
-                rd::mem::Overwrite(widthCheck, branchFix);
-        }
+    rd::mem::PatchBatch patches;
+    if (HAS_SIG(game, widthCheck)) {
+        uint32_t branchFix = 0x3A5F43E8; 
+        for (uintptr_t widthCheck : rd::hook::SigScanArray({ "game", "widthCheck" }, true))
+            patches.Overwrite(widthCheck, branchFix);
+    }
 
-        if (rd::config::config["gamedef"]["signatures"]["game"].has("fontAlinePtr"))
-            rd::mem::Overwrite(rd::hook::SigScan("game", "fontAlinePtr"), &ourTable[0]);
+    if (HAS_SIG(game, fontAlinePtr))
+        patches.Overwrite(rd::hook::SigScan({ "game", "fontAlinePtr" }), &ourTable[0]);
 
-        if (rd::config::config["gamedef"]["signatures"]["game"].has("fontAline2Ptr"))
-            rd::mem::Overwrite(rd::hook::SigScan("game", "fontAline2Ptr"), &ourTable[0]);
+    if (HAS_SIG(game, fontAline2Ptr))
+        patches.Overwrite(rd::hook::SigScan({ "game", "fontAline2Ptr" }), &ourTable[0]);
 
-        AtlasDialogueMargin = rd::config::config["patchdef"]["base"]["atlasDialogueMargin"].get<float>();
-        AtlasOutlineMargin = rd::config::config["patchdef"]["base"]["atlasOutlineMargin"].get<float>();
-        DialogueOutlineOffset = rd::config::config["patchdef"]["base"]["dialogueOutlineOffset"].get<float>();
+    if (rd::config::config.patchdef.outlinedFont) {
+        OutlinedFont = true;
+        HOOK_FUNC(game, MEStvramDrawEx);
+    }
 
-        if (rd::config::config["patchdef"]["base"]["outlinedFont"].get<bool>()) {
-            OutlinedFont = true;
-            HOOK_FUNC(game, MEStvramDrawEx);
-        }
+    HOOK_FUNC(game, GSLfontStretchF);
+    HOOK_FUNC(game, GSLfontStretchWithMaskF);
+    HOOK_FUNC(game, GSLfontStretchWithMaskExF);
+    HOOK_FUNC(game, MESsetNGflag);
+}
 
-        HOOK_FUNC(game, GSLfontStretchF);
-        HOOK_FUNC(game, GSLfontStretchWithMaskF);
-        HOOK_FUNC(game, GSLfontStretchWithMaskExF);
-        HOOK_FUNC(game, MESsetNGflag);
-    }
+static void InitTips(const feature::Context&) {
+    HOOK_VAR(game, EPmaxPtr);
 
-    if (rd::config::config["patchdef"]["base"]["tipReimplementation"].get<bool>()) {
-        rd::mem::Trampoline(
-            rd::hook::SigScan("game", "englishTipsFixBranch1"),
-            (uintptr_t)&englishTipsBranchFix,
-            reg::X0
-        );
+    rd::mem::PatchBatch patches;
+    rd::mem::Trampoline(
+        patches,
+        rd::hook::SigScan({ "game", "englishTipsFixBranch1" }),
+        (uintptr_t)&englishTipsBranchFix,
+        reg::X0
+    );
 
-        rd::mem::Trampoline(
-            rd::hook::SigScan("game", "englishTipsFixBranch2"),
-            (uintptr_t)&englishTipsBranchFix,
-            reg::X0
-        );
+    rd::mem::Trampoline(
+        patches,
+        rd::hook::SigScan({ "game", "englishTipsFixBranch2" }),
+        (uintptr_t)&englishTipsBranchFix,
+        reg::X0
+    );
 
-        HOOK_FUNC(game, TipsDataInit);
-    }
+    HOOK_FUNC(game, TipsDataInit);
+}
 
-    if (rd::config::config["patchdef"]["base"]["chnRedoChat"].get<bool>()) {
-        HOOK_FUNC(game, ChatLayout);
-        HOOK_FUNC(game, ChatRendering);
-    }
+static void InitChat(const feature::Context&) {
+    HOOK_VAR(game, MesFontColor);
+
+    HOOK_FUNC(game, ChatLayout);
+    HOOK_FUNC(game, ChatRendering);
+}
 
+static void InitMenuText(const feature::Context&) {
     HOOK_FUNC(game, MESdrawTextExF);
+}
 
-    if (rd::config::config["patchdef"]["base"]["addNametags"].get<bool>()) {
-        NametagImplementation = true;
-        HOOK_FUNC(game, MESrevDispInit);
-        HOOK_FUNC(game, MESrevDispText);
-    }
+static void InitNametags(const feature::Context&) {
+    HOOK_VAR(game, MESrevLineBufUsePtr);
+    HOOK_VAR(game, MESrevDispLinePos);
+    HOOK_VAR(game, MESrevLineBufp);
+    HOOK_VAR(game, MESrevText);
+    HOOK_VAR(game, MESrevDispLinePosY);
+    HOOK_VAR(game, MESrevTextSize);
+    HOOK_VAR(game, MESrevTextPos);
+    HOOK_VAR(game, MESrevDispPosPtr);
+    HOOK_VAR(game, MESrevDispMaxPtr);
 
-    if (rd::config::config["patchdef"]["base"]["addBacklogOutline"].get<bool>()) {
-        AddBacklogOutline = true;
-    }
+    NametagImplementation = true;
+    HOOK_FUNC(game, MESrevDispInit);
+    HOOK_FUNC(game, MESrevDispText);
+}
+
+static void InitBacklogOutline(const feature::Context&) {
+    AddBacklogOutline = true;
+}
+
+// Chat and nametags draw through the font hooks' trampolines, text has to be on for them
+static constexpr feature::Module TextModules[] = {
+    { "widths", feature::Activation::Required, nullptr, nullptr, nullptr, InitWidths },
+    { "text", feature::Activation::Option, &rd::config::Patchdef::hookText, "system widths",
+      "game/MesNameDispLen game/MEStextDatNumPtr game/MESngFontListTopNumPtr game/MESngFontListLastNumPtr "
+      "game/MEStextFl game/MEStext game/MESngFontListLast game/MESngFontListTop game/englishOnlyOffsetTable "
+      "game/widthCheck game/fontAlinePtr game/fontAline2Ptr game/MEStvramDrawEx game/GSLfontStretchF "
+      "game/GSLfontStretchWithMaskF game/GSLfontStretchWithMaskExF game/MESsetNGflag",
+      InitText },
+    { "tips", feature::Activation::Option, &rd::config::Patchdef::tipReimplementation, nullptr,
+      "game/EPmaxPtr game/englishTipsFixBranch1 game/englishTipsFixBranch2 game/TipsDataInit game/TipsEPmaxCmp "
+      "game/SystemMenuDisp",
+      InitTips },
+    { "chat", feature::Activation::Option, &rd::config::Patchdef::chnRedoChat, "text widths scriptWork scriptExpressions",
+      "game/MesFontColor game/ChatLayout game/ChatRendering", InitChat },
+    { "menuText", feature::Activation::Always, nullptr, nullptr, "game/MESdrawTextExF", InitMenuText },
+    { "nametags", feature::Activation::Option, &rd::config::Patchdef::addNametags, "system text widths",
+      "game/MESrevLineBufUsePtr game/MESrevDispLinePos game/MESrevLineBufp game/MESrevText "
+      "game/MESrevDispLinePosY game/MESrevTextSize game/MESrevTextPos game/MESrevDispPosPtr game/MESrevDispMaxPtr "
+      "game/MESrevDispInit game/MESrevDispText",
+      InitNametags },
+    { "backlogOutline", feature::Activation::Option, &rd::config::Patchdef::addBacklogOutline, "text", nullptr, InitBacklogOutline },
+};
+
+std::span<const feature::Module> Modules() {
+    return TextModules;
 }
 
 }  // namespace text
@@ -2,6 +2,7 @@
 
 #include <cstddef>
 
+#include "Feature.h"
 #include "Hook.h"
 
 #define MAX_PROCESSED_STRING_LENGTH 2000
@@ -36,7 +37,9 @@ inline uint8_t *MESrevTextSize = nullptr;
 inline unsigned short *MESrevTextPos = nullptr;
 inline uint32_t *MESrevDispPosPtr = nullptr;
 inline uint32_t *MESrevDispMaxPtr = nullptr;
-inline uint8_t ourTable[8000] = { 0 };
+// Glyph widths from widths.bin, fontAlinePtr is patched to point the game at them
+inline constexpr size_t WidthTableSize = 8000;
+inline uint8_t ourTable[WidthTableSize];
 
 DECLARE_HOOK(GSLfontStretchF, int,
             int fontSurfaceId,
@@ -81,7 +84,7 @@ DECLARE_HOOK(MESrevDispText, void,
 DECLARE_HOOK(MEStvramDrawEx, void,
             int param_1, ulong param_2, int param_3, int param_4, int param_5);
 
-void Init(std::string const &romMount);
+std::span<const feature::Module> Modules();
 
 }  // namespace text
 }  // namespace rd
@@ -0,0 +1,193 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#ifdef __SWITCH__
+#include <lib.hpp>
+#include <lib/libsetting.hpp>
+#include <log/logger_mgr.hpp>
+#include <skyline/utils/cpputils.hpp>
+
+#include "Sd.h"
+#endif
+
+#include "Trace.h"
+
+using namespace std;
+
+namespace rd {
+namespace trace {
+
+uint64_t Now() {
+#ifdef __SWITCH__
+    return svcGetSystemTick();
+#else
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+uint64_t Frequency() {
+#ifdef __SWITCH__
+    return 19200000;
+#else
+    return 1000000000;
+#endif
+}
+
+#if RD_TRACE
+
+struct Event {
+    const char* category;
+    const char* name;
+    uint64_t start;
+    uint64_t end;
+    uint32_t thread;
+};
+
+// Spans come from the scan workers too, and are short enough for a spinlock
+static Event s_Events[MaxEvents];
+static size_t s_Count = 0;
+static size_t s_Dropped = 0;
+static bool s_Stopped = false;
+static atomic_flag s_Lock = ATOMIC_FLAG_INIT;
+
+static atomic<uint32_t> s_NextThread = 1;
+static thread_local uint32_t t_Thread = 0;
+
+uint32_t CurrentThread() {
+    if (t_Thread == 0) t_Thread = s_NextThread++;
+    return t_Thread;
+}
+
+void Record(const char* category, const char* name, uint64_t start, uint64_t end) {
+    uint32_t thread = CurrentThread();
+
+    while (s_Lock.test_and_set(memory_order_acquire)) {}
+    if (!s_Stopped) {
+        if (s_Count < MaxEvents) s_Events[s_Count++] = { category, name, start, end, thread };
+        else s_Dropped++;
+    }
+    s_Lock.clear(memory_order_release);
+}
+
+// Collects small pieces of JSON and hands them to the writer in chunks
+class TraceWriter {
+  public:
+    TraceWriter(Writer write, void* context) : write(write), context(context) {}
+
+    void Put(const char* data, size_t size) {
+        while (ok && size > 0) {
+            size_t count = min(size, sizeof(buffer) - used);
+            memcpy(buffer + used, data, count);
+            used += count;
+            data += count;
+            size -= count;
+            if (used == sizeof(buffer)) Flush();
+        }
+    }
+
+    void Put(const char* text) { Put(text, strlen(text)); }
+
+    void PutString(const char* text) {
+        Put("\"", 1);
+        for (; *text; text++) {
+            if (*text == '"' || *text == '\\') Put("\\", 1);
+            if ((unsigned char)*text >= 0x20) Put(text, 1);
+        }
+        Put("\"", 1);
+    }
+
+    bool Flush() {
+        if (ok && used > 0) ok = write(context, buffer, used);
+        used = 0;
+        return ok;
+    }
+
+  private:
+    Writer write;
+    void* context;
+    char buffer[256];
+    size_t used = 0;
+    bool ok = true;
+};
+
+bool WriteJson(Writer write, void* context) {
+    // Spans below the count are never written again, so they can be read outside the lock
+    while (s_Lock.test_and_set(memory_order_acquire)) {}
+    size_t count = s_Count;
+    s_Lock.clear(memory_order_release);
+
+    // Timestamps are microseconds, from the first span on
+    uint64_t origin = UINT64_MAX;
+    for (size_t i = 0; i < count; i++) origin = min(origin, s_Events[i].start);
+    double scale = 1e6 / Frequency();
+
+    TraceWriter out(write, context);
+    out.Put("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    char buffer[128];
+
+    for (size_t i = 0; i < count; i++) {
+        const Event& event = s_Events[i];
+        out.Put(i == 0 ? "\n{\"name\":" : ",\n{\"name\":");
+        out.PutString(event.name);
+        out.Put(",\"cat\":");
+        out.PutString(event.category);
+        int length = snprintf(buffer, sizeof(buffer), ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}",
+                              (event.start - origin) * scale, (event.end - event.start) * scale, event.thread);
+        out.Put(buffer, length);
+    }
+
+    out.Put("\n]}\n");
+    return out.Flush();
+}
+
+#ifdef __SWITCH__
+struct SaveFile {
+    nn::fs::FileHandle handle;
+    int64_t position;
+};
+
+static bool WriteToFile(void* context, const char* data, size_t size) {
+    auto* file = static_cast<SaveFile*>(context);
+    Result rc = nn::fs::WriteFile(file->handle, file->position, data, size, nn::fs::WriteOption::CreateOption(0));
+    if (R_FAILED(rc)) {
+        Logging.Log("Trace: write failed: 0x%x\n", rc);
+        return false;
+    }
+    file->position += size;
+    return true;
+}
+
+void Save() {
+    while (s_Lock.test_and_set(memory_order_acquire)) {}
+    s_Stopped = true;
+    s_Lock.clear(memory_order_release);
+
+    if (!sd::Mount()) return;
+
+    char path[64];
+    snprintf(path, sizeof(path), "%s/trace_%016lX.json", sd::Directory, exl::setting::ProgramId);
+
+    nn::fs::CreateDirectory(sd::Directory);
+    nn::fs::DeleteFile(path);
+
+    SaveFile file = { {}, 0 };
+    Result rc = nn::fs::CreateFile(path, 0);
+    if (R_SUCCEEDED(rc)) rc = nn::fs::OpenFile(&file.handle, path, nn::fs::OpenMode_Write | nn::fs::OpenMode_Append);
+    if (R_FAILED(rc)) {
+        Logging.Log("Trace: failed to open %s: 0x%x\n", path, rc);
+        return;
+    }
+
+    bool written = WriteJson(WriteToFile, &file) && R_SUCCEEDED(nn::fs::FlushFile(file.handle));
+    nn::fs::CloseFile(file.handle);
+
+    if (written) Logging.Log("Trace: wrote %lu spans to %s, dropped %lu\n", s_Count, path, s_Dropped);
+}
+#endif
+
+#endif
+
+}  // namespace trace
+}  // namespace rd
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Spans are only kept by developer builds (-DRD_DEVELOPER=ON) and the host tools,
+// everywhere else Span and Record compile to nothing
+#if defined(RD_DEVELOPER) || !defined(__SWITCH__)
+#define RD_TRACE 1
+#else
+#define RD_TRACE 0
+#endif
+
+namespace rd {
+namespace trace {
+
+    inline constexpr bool Enabled = RD_TRACE;
+
+    // At most this many spans are kept, later ones are counted and dropped
+    inline constexpr size_t MaxEvents = 512;
+
+    // Monotonic time in ticks: the system tick counter on the device, a steady clock on the host
+    uint64_t Now();
+
+    // Ticks per second
+    uint64_t Frequency();
+
+#if RD_TRACE
+    // Small id of the calling thread, threads are numbered in the order they start tracing something
+    uint32_t CurrentThread();
+
+    // Records a span that ran from start to end on the calling thread, until Save has run.
+    // category and name are kept as they are, so they must outlive the trace: literals or the config.
+    void Record(const char* category, const char* name, uint64_t start, uint64_t end);
+#else
+    inline uint32_t CurrentThread() { return 0; }
+    inline void Record(const char*, const char*, uint64_t, uint64_t) {}
+#endif
+
+    // Records its own lifetime, spans within it show up nested under it
+    class Span {
+      public:
+        Span(const char* category, const char* name) : category(category), name(name) {
+            if constexpr (Enabled) {
+                CurrentThread();
+                start = Now();
+            }
+        }
+        ~Span() {
+            if constexpr (Enabled) Record(category, name, start, Now());
+        }
+
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+
+      private:
+        const char* category;
+        const char* name;
+        uint64_t start = 0;
+    };
+
+#if RD_TRACE
+    // Receives the JSON a piece at a time, returns false to stop writing
+    using Writer = bool (*)(void* context, const char* data, size_t size);
+
+    // Streams every span so far as Chrome trace-event JSON, for chrome://tracing or ui.perfetto.dev
+    bool WriteJson(Writer write, void* context);
+#endif
+
+    // Stops recording and writes the trace to the SD card, device only
+#if RD_TRACE && defined(__SWITCH__)
+    void Save();
+#else
+    inline void Save() {}
+#endif
+
+}  // namespace trace
+}  // namespace rd
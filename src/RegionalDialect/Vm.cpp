@@ -1,5 +1,7 @@
+#include <algorithm>
 #include <cstdint>
 #include <concepts>
+#include <vector>
 
 #include <frozen/unordered_map.h>
 #include <frozen/string.h>
@@ -67,13 +69,12 @@ static uintptr_t SlotToPtr(int table, int opcode) {
 }
 
 static void InsertCustomInstructions() {
-    if (!rd::config::config["patchdef"]["base"].has("customInstructions")) return;
-
-    auto toInsert =
-        rd::config::config["patchdef"]["base"]["customInstructions"].get<std::vector<rd::config::JsonWrapper>>();
+    const auto& toInsert = rd::config::config.patchdef.instructions;
+    rd::mem::PatchBatch patches;
+    std::vector<uintptr_t> inserted;  // Slots only change once the batch is committed
 
     for (auto inst = toInsert.begin(); inst != toInsert.end(); inst++) {
-        const std::string_view name = inst->getName();
+        const std::string_view name = inst->name;
 
         if (name.empty()) {
             Logging.Log("Missing instruction name at index '%u'! Skipping...\n", inst - toInsert.begin());
@@ -87,8 +88,8 @@ static void InsertCustomInstructions() {
             continue;
         }
 
-        int table = (*inst)["table"].get<int>();
-        int opcode = (*inst)["opcode"].get<int>();
+        int table = inst->table;
+        int opcode = inst->opcode;
 
         uintptr_t address = SlotToPtr(table, opcode);
 
@@ -97,15 +98,18 @@ static void InsertCustomInstructions() {
             continue;
         };
 
-        if (*reinterpret_cast<uint32_t*>(address) != 0 &&                       // Non-empty slot
-            **reinterpret_cast<uint32_t**>(address) != inst::Ret().Value()) {   // Not a dummy instruction
+        bool taken = std::find(inserted.begin(), inserted.end(), address) != inserted.end();
+        if (taken ||
+            (*reinterpret_cast<uint32_t*>(address) != 0 &&                      // Non-empty slot
+             **reinterpret_cast<uint32_t**>(address) != inst::Ret().Value())) { // Not a dummy instruction
             Logging.Log("%s cannot be inserted into slot %02X %02X: "
                         "Possibly overwriting existing instruction!",
                         itr->first.data(), table, opcode);
             continue;
         }
 
-        rd::mem::Overwrite(address, reinterpret_cast<uintptr_t>(itr->second));
+        patches.Overwrite(address, reinterpret_cast<uintptr_t>(itr->second));
+        inserted.push_back(address);
         Logging.Log("%s inserted at %02X %02X!", itr->first.data(), table, opcode);
     }
 }
@@ -114,14 +118,28 @@ void CalMain::Callback(ScriptThreadState *param_1, int32_t *param2) {
     Orig(param_1, param2);
 }
 
-void Init() {
+static void InitScriptExpressions(const feature::Context&) {
+    BIND_FUNC(game, CalMain);
+}
+
+static void InitCustomInstructions(const feature::Context&) {
     HOOK_VAR(game, SCRuser1);
     HOOK_VAR(game, SCRgraph);
     HOOK_VAR(game, SCRsystem);
 
-    HOOK_FUNC(game, CalMain);
-
     InsertCustomInstructions();
 }
+
+static constexpr feature::Module VmModules[] = {
+    { "scriptExpressions", feature::Activation::Required, nullptr, nullptr, "game/CalMain", InitScriptExpressions },
+    // GetDic sets a flag from the tip dictionary
+    { "customInstructions", feature::Activation::Option, &rd::config::Patchdef::customInstructions, "system dictionary scriptExpressions",
+      "game/SCRuser1 game/SCRgraph game/SCRsystem", InitCustomInstructions },
+};
+
+std::span<const feature::Module> Modules() {
+    return VmModules;
+}
+
 }  // namespace vm
 }  // namespace rd
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include <cstddef>
 
+#include "Feature.h"
 #include "Hook.h"
 
 namespace rd {
@@ -30,7 +31,7 @@ struct ScriptThreadState {
   /* 014C */ std::byte *pc;
 };
 
-DECLARE_HOOK(CalMain, void, ScriptThreadState *param_1, int32_t *param_2);
+DECLARE_FUNC(CalMain, void, ScriptThreadState *param_1, int32_t *param_2);
 
 inline void PopOpcode(ScriptThreadState *thread) {
     thread->pc += 2;
@@ -49,7 +50,7 @@ template <std::integral T>
     return ret;
 }
 
-void Init();
+std::span<const feature::Module> Modules();
 
 }  // namespace vm
 }  // namespace rd
\ No newline at end of file
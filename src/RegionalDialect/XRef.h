@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "Decode.h"
+
+namespace rd {
+namespace mem {
+
+    // Pairs further apart than this, in instructions, are never considered
+    inline constexpr size_t XRefMaxDistance = 64;
+
+    // Calls found(adrp, use, target) for every ADRP+ADD/LDR/STR pair in the code from start to end, mapped at
+    // address, in the order of the instructions completing them, until it returns false. Nothing is kept besides
+    // the registers, so any stretch of .text can be searched without memory to spare.
+    // Registers are followed across the instructions in between, a pair is dropped as soon as anything may have
+    // overwritten the ADRP's register, so some pairs are missed but none are made up. Pairs whose ADRP is in the
+    // range are found the same wherever the range starts.
+    template <typename F>
+    void ForEachXRef(const uint8_t* start, const uint8_t* end, uintptr_t address, F&& found) {
+        // Page each register got from an ADRP, and where that ADRP is
+        uintptr_t pages[32];
+        size_t adrps[32];
+        uint32_t live = 0;
+
+        size_t count = (end - start) / 4;
+        for (size_t i = 0; i < count; i++) {
+            uint32_t inst;
+            memcpy(&inst, start + i * 4, sizeof(inst));
+
+            auto complete = [&](uint32_t reg, uintptr_t offset) {
+                if (!(live & (1u << reg)) || i - adrps[reg] > XRefMaxDistance) return true;
+                return found(address + adrps[reg] * 4, address + i * 4, pages[reg] + offset);
+            };
+
+            if (IsAdrp(inst)) {
+                pages[Rd(inst)] = DecodeAdrp(address + i * 4, inst);
+                adrps[Rd(inst)] = i;
+                live |= 1u << Rd(inst);
+                continue;
+            }
+
+            if (IsAddImmediate64(inst)) {
+                if (!complete(Rn(inst), DecodeAddImmediate(inst))) return;
+            } else if (IsLoadStoreUnsignedOffset(inst)) {
+                if (!complete(Rn(inst), DecodeLoadStoreOffset(inst))) return;
+
+                // Stores and SIMD loads leave general purpose registers alone
+                bool simd = inst & 0x04000000;
+                bool load = inst & 0x00C00000;
+                if (simd || !load) continue;
+            } else if ((inst & 0x7C000000) == 0x14000000 || (inst & 0xFE000000) == 0xD6000000) {
+                // B/BL and branches to registers: calls clobber registers and the rest leave
+                live = 0;
+                continue;
+            } else if ((inst & 0x3A400000) == 0x28400000) {
+                // Load pairs write a second register
+                live &= ~(1u << ((inst >> 10) & 0x1F));
+            }
+
+            // Nearly everything else writes bits 0-4, assume it does
+            live &= ~(1u << Rd(inst));
+        }
+    }
+
+}  // namespace mem
+}  // namespace rd
@@ -4,11 +4,9 @@
 #include <log/logger_mgr.hpp>
 #include <lib.hpp>
 #include <hook/trampoline.hpp>
+#include <nn/fs.hpp>
 
-#include "RegionalDialect/Config.h"
-#include "RegionalDialect/System.h"
-#include "RegionalDialect/Text.h"
-#include "RegionalDialect/Vm.h"
+#include "RegionalDialect/Startup.h"
 
 uintptr_t codeCaves = 0;
 
@@ -19,6 +17,13 @@ namespace fs {
 }  // namespace nn
 
 // clang-format off
+HOOK_DEFINE_TRAMPOLINE(OpenFile) {
+    static Result Callback(nn::fs::FileHandle* outHandle, char const* path, int mode) {
+        rd::startup::Commit();
+        return Orig(outHandle, path, mode);
+    }
+};
+
 HOOK_DEFINE_TRAMPOLINE(MountRom) {
     static Result Callback(char const* path, void* buffer, unsigned long size) {
         static bool hasMounted = false;
@@ -29,15 +34,9 @@ HOOK_DEFINE_TRAMPOLINE(MountRom) {
             if (R_SUCCEEDED(ret)) {
                 Logging.Log("[RegionalDialect] Mounted ROM successfully.\n");
                 hasMounted = true;
-                std::string romMount = std::string(path) + ":/"; 
-                rd::config::Init(romMount);
-                Logging.Log("[RegionalDialect] Finished config init.\n");
-                rd::sys::Init();
-                Logging.Log("[RegionalDialect] Finished sys init.\n");
-                rd::vm::Init();
-                Logging.Log("[RegionalDialect] Finished vm init.\n");
-                rd::text::Init(romMount);
-                Logging.Log("[RegionalDialect] Finished initialization.\n");
+                // The ROM is mounted early in boot, the game only needs our hooks once it starts opening files
+                OpenFile::InstallAtFuncPtr(nn::fs::OpenFile);
+                rd::startup::Begin(std::string(path) + ":/");
             } else {
                 Logging.Log("[RegionalDialect] Failed to mount ROM: 0x%x\n", ret);
             }
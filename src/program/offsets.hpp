@@ -11,7 +11,8 @@ namespace exl::reloc {
     template<VersionType Version, impl::LookupEntry... Entries>
     using UserTableType = VersionedTable<Version, Entries...>;
 
-    using UserTableSet = TableSet<VersionType 
+    /* Known builds' tables come from offsets/, see version.hpp. */
+    using UserTableSet = TableSet<VersionType RD_KNOWN_BUILD_TABLES
         /*
         // This feature allows you to specify symbols in your executable to resolve with module+offset pairs.
         // They are packed up and sorted at compile time so they can be efficiently looked up.
@@ -1,24 +1,58 @@
 #pragma once
 
 #include <common.hpp>
+#include <span>
+
+#include <lib/util/murmur3.hpp>
+#include <lib/util/sys/mem_layout.hpp>
+#include <lib/util/sys/modules.hpp>
+
+/* Builds with offsets resolved ahead of time, generated from offsets/ by the build. */
+#if __has_include(<known_builds.hpp>)
+#include <known_builds.hpp>
+#else
+#define RD_KNOWN_BUILDS(X)
+#define RD_KNOWN_BUILD_TABLES
+#endif
 
 namespace exl::util {
 
-    /* Add versions here if you want to take advantage of this feature. */
-    enum class UserVersion {
+    /* Each known build is identified by the hash DetermineUserVersion computes for it. */
+    enum class UserVersion : uint32_t {
         DEFAULT,
-        /* Members can be assigned any constant of your choosing. */
-        /* OTHER = 123 */
+        #define RD_USER_VERSION(name, hash) name = hash,
+        RD_KNOWN_BUILDS(RD_USER_VERSION)
+        #undef RD_USER_VERSION
     };
 
     namespace impl {
+        /* Murmur3 of .text, then of .rodata seeded with it. tools/sigresolve computes the same for --save-offsets. */
+        inline uint32_t ComputeBuildHash(std::span<const char> text, std::span<const char> rodata) {
+            return Murmur3::Compute(rodata, Murmur3::Compute(text));
+        }
+
         ALWAYS_INLINE UserVersion DetermineUserVersion() {
-            /* 
-                Implement a method of determining your application version here if you want to take advantage of this feature.
-                An example may be apply Murmur3 over the .text and .rodata of the main executable or calling nn::oe::GetDisplayVersion.
-                The former would have complications if other mods are in effect, and the latter may have issues with people doing safe downgrades on console.
+            /*
+                Known builds are told apart by hashing the main executable's .text and .rodata.
+                Anything else, including known builds other mods have patched, is left as DEFAULT and scanned for at runtime.
             */
-            return UserVersion::DEFAULT;
+            #define RD_COUNT_BUILD(name, hash) + 1
+            if constexpr ((0 RD_KNOWN_BUILDS(RD_COUNT_BUILD)) == 0)
+                return UserVersion::DEFAULT;
+            #undef RD_COUNT_BUILD
+
+            const auto& module = GetMainModuleInfo();
+            uint32_t hash = ComputeBuildHash(
+                { reinterpret_cast<const char*>(module.m_Text.m_Start), module.m_Text.m_Size },
+                { reinterpret_cast<const char*>(module.m_Rodata.m_Start), module.m_Rodata.m_Size }
+            );
+
+            switch (static_cast<UserVersion>(hash)) {
+                #define RD_MATCH_BUILD(name, hash) case UserVersion::name: return UserVersion::name;
+                RD_KNOWN_BUILDS(RD_MATCH_BUILD)
+                #undef RD_MATCH_BUILD
+                default: return UserVersion::DEFAULT;
+            }
         }
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,189 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <span>
+
+#include <lib/util/murmur3.hpp>
+
+#include "ModuleImage.h"
+
+using namespace std;
+
+bool ReadFile(const char* path, vector<uint8_t>& out) {
+    ifstream file(path, ios::binary);
+    if (!file) return false;
+    out.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+    return true;
+}
+
+template <typename T>
+static T ReadValue(const uint8_t* data) {
+    T value;
+    memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+// NSO segments are LZ4 blocks, without any frame around them
+static bool Lz4Decompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize) {
+    const uint8_t* ip = src;
+    const uint8_t* const ipEnd = src + srcSize;
+    uint8_t* op = dst;
+    uint8_t* const opEnd = dst + dstSize;
+
+    auto readLength = [&](size_t& length) {
+        uint8_t byte;
+        do {
+            if (ip >= ipEnd) return false;
+            byte = *ip++;
+            length += byte;
+        } while (byte == 0xFF);
+        return true;
+    };
+
+    while (ip < ipEnd) {
+        uint8_t token = *ip++;
+
+        size_t literals = token >> 4;
+        if (literals == 15 && !readLength(literals)) return false;
+        if (literals > static_cast<size_t>(ipEnd - ip) || literals > static_cast<size_t>(opEnd - op)) return false;
+
+        memcpy(op, ip, literals);
+        ip += literals;
+        op += literals;
+
+        // The last sequence is only literals
+        if (ip >= ipEnd) break;
+
+        if (ipEnd - ip < 2) return false;
+        size_t offset = ip[0] | ip[1] << 8;
+        ip += 2;
+        if (offset == 0 || offset > static_cast<size_t>(op - dst)) return false;
+
+        size_t length = (token & 0xF) + 4;
+        if ((token & 0xF) == 15 && !readLength(length)) return false;
+        if (length > static_cast<size_t>(opEnd - op)) return false;
+
+        // Byte by byte, the match may overlap what it's writing
+        for (size_t i = 0; i < length; i++, op++) *op = op[-offset];
+    }
+
+    return op == opEnd;
+}
+
+bool ModuleImage::LoadNso(const vector<uint8_t>& file, string& error) {
+    if (file.size() < 0x100) {
+        error = "NSO header is truncated";
+        return false;
+    }
+
+    struct Segment {
+        uint32_t fileOffset;
+        uint32_t memoryOffset;
+        uint32_t size;
+        uint32_t fileSize;
+    } segments[3];
+
+    uint32_t flags = ReadValue<uint32_t>(&file[0xC]);
+    for (int i = 0; i < 3; i++) {
+        segments[i].fileOffset = ReadValue<uint32_t>(&file[0x10 + i * 0x10]);
+        segments[i].memoryOffset = ReadValue<uint32_t>(&file[0x14 + i * 0x10]);
+        segments[i].size = ReadValue<uint32_t>(&file[0x18 + i * 0x10]);
+        segments[i].fileSize = ReadValue<uint32_t>(&file[0x60 + i * 4]);
+    }
+
+    memory.assign(segments[2].memoryOffset + segments[2].size, 0);
+
+    for (int i = 0; i < 3; i++) {
+        const Segment& segment = segments[i];
+        bool compressed = flags & (1 << i);
+        size_t fileSize = compressed ? segment.fileSize : segment.size;
+
+        if (segment.fileOffset + fileSize > file.size() || segment.memoryOffset + segment.size > memory.size()) {
+            error = "NSO segment " + to_string(i) + " is out of bounds";
+            return false;
+        }
+
+        if (!compressed) {
+            memcpy(&memory[segment.memoryOffset], &file[segment.fileOffset], segment.size);
+        } else if (!Lz4Decompress(&file[segment.fileOffset], fileSize, &memory[segment.memoryOffset], segment.size)) {
+            error = "NSO segment " + to_string(i) + " failed to decompress";
+            return false;
+        }
+    }
+
+    textStart = segments[0].memoryOffset;
+    textEnd = segments[1].memoryOffset;
+    rodataEnd = segments[1].memoryOffset + segments[1].size;
+    dataStart = segments[2].memoryOffset;
+    dataEnd = memory.size();
+    nso = true;
+    return true;
+}
+
+// Pointers in the file are only filled in by the loader, so do what it does
+void ModuleImage::ApplyRelocations() {
+    constexpr uint64_t DT_NULL = 0, DT_RELA = 7, DT_RELASZ = 8;
+    constexpr uint32_t R_AARCH64_RELATIVE = 0x403;
+
+    if (memory.size() < 8) return;
+    uint32_t mod0 = ReadValue<uint32_t>(&memory[4]);
+    if (mod0 + 8 > memory.size() || memcmp(&memory[mod0], "MOD0", 4) != 0) return;
+
+    uint64_t rela = 0, relaSize = 0;
+    for (size_t dyn = mod0 + ReadValue<int32_t>(&memory[mod0 + 4]); dyn + 16 <= memory.size(); dyn += 16) {
+        uint64_t tag = ReadValue<uint64_t>(&memory[dyn]);
+        uint64_t value = ReadValue<uint64_t>(&memory[dyn + 8]);
+        if (tag == DT_NULL) break;
+        if (tag == DT_RELA) rela = value;
+        if (tag == DT_RELASZ) relaSize = value;
+    }
+
+    for (uint64_t entry = rela; entry + 24 <= rela + relaSize && entry + 24 <= memory.size(); entry += 24) {
+        uint64_t offset = ReadValue<uint64_t>(&memory[entry]);
+        uint64_t info = ReadValue<uint64_t>(&memory[entry + 8]);
+        int64_t addend = ReadValue<int64_t>(&memory[entry + 16]);
+
+        uint64_t pointer = base + addend;
+        if ((info & 0xFFFFFFFF) == R_AARCH64_RELATIVE && offset + 8 <= memory.size())
+            memcpy(&memory[offset], &pointer, sizeof(pointer));
+    }
+}
+
+bool ModuleImage::Load(const char* path, size_t textSize, string& error) {
+    vector<uint8_t> file;
+    if (!ReadFile(path, file)) {
+        error = string("could not read ") + path;
+        return false;
+    }
+
+    if (file.size() >= 4 && memcmp(file.data(), "NSO0", 4) == 0) {
+        if (!LoadNso(file, error)) return false;
+    } else {
+        memory = std::move(file);
+        nso = false;
+        textStart = 0;
+        textEnd = textSize != 0 && textSize < memory.size() ? textSize : memory.size();
+        rodataEnd = dataStart = dataEnd = memory.size();
+    }
+
+    ApplyRelocations();
+    return true;
+}
+
+bool ModuleImage::Read(uintptr_t address, void* out, size_t size) const {
+    if (address < base || address - base > memory.size() || size > memory.size() - (address - base)) return false;
+    memcpy(out, &memory[address - base], size);
+    return true;
+}
+
+// Same as exl::util::impl::ComputeBuildHash, over .rodata as it's mapped: padded with zeroes to a whole page
+uint32_t ModuleImage::BuildHash() const {
+    using exl::util::Murmur3;
+    constexpr size_t PageSize = 0x1000;
+
+    size_t rodataMapped = min((rodataEnd + PageSize - 1) & ~(PageSize - 1), dataStart);
+    span<const char> text((const char*)&memory[textStart], textEnd - textStart);
+    span<const char> rodata((const char*)&memory[textEnd], rodataMapped - textEnd);
+    return Murmur3::Compute(rodata, Murmur3::Compute(text));
+}
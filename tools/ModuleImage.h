@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A game's main module laid out the way it is in memory, loaded at the base disassemblers use for it.
+// Loads NSO files straight from an exefs, compressed or not, or flat dumps starting at .text.
+struct ModuleImage {
+    static constexpr uintptr_t DefaultBase = 0x7100000000;
+
+    std::vector<uint8_t> memory;
+    uintptr_t base = DefaultBase;
+
+    // Offsets into memory
+    size_t textStart = 0;
+    size_t textEnd = 0;  // Start of .rodata, the same range the module scans
+    size_t rodataEnd = 0;
+    size_t dataStart = 0;
+    size_t dataEnd = 0;
+
+    bool nso = false;  // Flat dumps don't say where .rodata is
+
+    // textSize splits a flat dump, the whole file is .text when it's 0
+    bool Load(const char* path, size_t textSize, std::string& error);
+
+    const uint8_t* Text() const { return memory.data() + textStart; }
+    const uint8_t* TextEnd() const { return memory.data() + textEnd; }
+
+    uintptr_t Address(size_t offset) const { return base + offset; }
+
+    bool Read(uintptr_t address, void* out, size_t size) const;
+
+    // What the module's DetermineUserVersion identifies this build by, only meaningful for NSOs
+    uint32_t BuildHash() const;
+
+  private:
+    bool LoadNso(const std::vector<uint8_t>& file, std::string& error);
+    void ApplyRelocations();
+};
+
+bool ReadFile(const char* path, std::vector<uint8_t>& out);
@@ -0,0 +1,33 @@
+#include <algorithm>
+
+#include "RegionalDialect/XRef.h"
+#include "XRefIndex.h"
+
+using namespace std;
+
+void XRefIndex::Build(const uint8_t* textStart, const uint8_t* textEnd, uintptr_t baseAddress) {
+    this->baseAddress = baseAddress;
+    byTarget.clear();
+
+    rd::mem::ForEachXRef(textStart, textEnd, baseAddress, [&](uintptr_t adrp, uintptr_t use, uintptr_t target) {
+        if (target >= baseAddress && target - baseAddress <= UINT32_MAX)
+            byTarget.push_back({ static_cast<uint32_t>(adrp - baseAddress), static_cast<uint32_t>(use - baseAddress),
+                                 static_cast<uint32_t>(target - baseAddress) });
+        return true;
+    });
+
+    sort(byTarget.begin(), byTarget.end(), [](const XRef& a, const XRef& b) {
+        return pair(a.target, a.use) < pair(b.target, b.use);
+    });
+}
+
+span<const XRef> XRefIndex::To(uintptr_t target) const {
+    if (target < baseAddress || target - baseAddress > UINT32_MAX) return {};
+    uint32_t offset = target - baseAddress;
+
+    auto first = lower_bound(byTarget.begin(), byTarget.end(), offset,
+                             [](const XRef& xref, uint32_t key) { return xref.target < key; });
+    auto last = upper_bound(first, byTarget.end(), offset,
+                            [](uint32_t key, const XRef& xref) { return key < xref.target; });
+    return { first, last };
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// An ADRP and the ADD, load or store completing the address it builds, as offsets from the index's base
+struct XRef {
+    uint32_t adrp;
+    uint32_t use;
+    uint32_t target;
+};
+
+// Every ADRP+ADD/LDR/STR pair in .text, decoded in one pass with rd::mem::ForEachXRef and sorted by what they
+// refer to. Takes several times the size of .text, the module searches the pairs it needs without it.
+class XRefIndex {
+  public:
+    void Build(const uint8_t* textStart, const uint8_t* textEnd, uintptr_t baseAddress);
+
+    size_t Size() const { return byTarget.size(); }
+
+    // Every pair referring to target, in address order
+    std::span<const XRef> To(uintptr_t target) const;
+
+    uintptr_t Address(uint32_t offset) const { return baseAddress + offset; }
+
+  private:
+    uintptr_t baseAddress = 0;
+    std::vector<XRef> byTarget;
+};
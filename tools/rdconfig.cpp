@@ -0,0 +1,68 @@
+// Compiles a game's gamedef.json and patchdef.json into the config.bin the module reads in their place,
+// with every signature pattern and expression already compiled, see RegionalDialect/ConfigBlob.h.
+// The blob is read back before it's written, so one that doesn't load on the device isn't written at all.
+// Usage: rdconfig <gamedef.json> <patchdef.json> <config.bin>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <lib/util/murmur3.hpp>
+
+#include "ModuleImage.h"
+#include "RegionalDialect/ConfigBlob.h"
+
+using namespace std;
+using namespace rd::config;
+using namespace rd::hook;
+
+static cJSON* ParseFile(const char* path, vector<uint8_t>& contents) {
+    cJSON* root = ReadFile(path, contents) ? cJSON_ParseWithLength((const char*)contents.data(), contents.size()) : nullptr;
+    if (!root) fprintf(stderr, "could not parse %s\n", path);
+    return root;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 4) {
+        fprintf(stderr, "usage: %s <gamedef.json> <patchdef.json> <config.bin>\n", argv[0]);
+        return 1;
+    }
+
+    vector<uint8_t> gamedefText, patchdefText;
+    cJSON* gamedef = ParseFile(argv[1], gamedefText);
+    cJSON* patchdef = ParseFile(argv[2], patchdefText);
+    if (!gamedef || !patchdef) return 1;
+
+    // Hashed the way the module hashes gamedef.json, so the scan cache tells them apart the same way
+    uint32_t gamedefHash = exl::util::Murmur3::Compute(string_view((const char*)gamedefText.data(), gamedefText.size()));
+
+    vector<string> errors;
+    vector<CompiledSignature> signatures = CompileSignatures(cJSON_GetObjectItem(gamedef, "signatures"), errors);
+    for (const string& message : errors) fprintf(stderr, "%s", message.c_str());
+
+    Patchdef base = ReadPatchdef(cJSON_GetObjectItem(patchdef, "base"));
+    vector<uint8_t> blob = WriteBlob(signatures, base, gamedefHash);
+
+    BlobContents contents;
+    string error;
+    if (!ReadBlob(blob, contents, error) || contents.signatures.size() != signatures.size()) {
+        fprintf(stderr, "the compiled config doesn't read back: %s\n", error.c_str());
+        return 1;
+    }
+
+    ofstream out(argv[3], ios::binary);
+    out.write((const char*)blob.data(), blob.size());
+    if (!out) {
+        fprintf(stderr, "could not write %s\n", argv[3]);
+        return 1;
+    }
+
+    printf("%s: %zu bytes, %zu signatures, %zu custom instructions (gamedef.json %zu bytes, patchdef.json %zu bytes)\n",
+           argv[3], blob.size(), signatures.size(), base.instructions.size(), gamedefText.size(), patchdefText.size());
+
+    cJSON_Delete(gamedef);
+    cJSON_Delete(patchdef);
+    return errors.empty() ? 0 : 1;
+}
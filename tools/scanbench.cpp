@@ -0,0 +1,233 @@
+// Times FindPattern against the previous std::search implementation on a .text dump.
+// Usage: scanbench <text.bin> <gamedef.json | pattern...>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "RegionalDialect/Pattern.h"
+#include "cJSON.h"
+
+using namespace std;
+
+namespace legacy {
+
+struct PatternByte {
+    struct PatternNibble {
+        unsigned char data;
+        bool wildcard;
+    } nibble[2];
+};
+
+static string FormatPattern(string_view patterntext) {
+    string result;
+    int len = patterntext.length();
+    for (int i = 0; i < len; i++)
+        if (patterntext[i] == '?' || isxdigit(patterntext[i]))
+        result += toupper(patterntext[i]);
+    return result;
+}
+
+static int HexChToInt(char ch) {
+    if (ch >= '0' && ch <= '9')
+        return ch - '0';
+    else if (ch >= 'A' && ch <= 'F')
+        return ch - 'A' + 10;
+    else if (ch >= 'a' && ch <= 'f')
+        return ch - 'a' + 10;
+    return 0;
+}
+
+static bool TransformPattern(string_view text, vector<PatternByte>& pattern) {
+    pattern.clear();
+    string patterntext = FormatPattern(text);
+    int len = patterntext.length();
+    if (!len) return false;
+
+    if (len % 2) {
+        patterntext += '?';
+        len++;
+    }
+
+    PatternByte newByte;
+    for (int i = 0, j = 0; i < len; i++) {
+        if (patterntext[i] == '?') {
+            newByte.nibble[j].wildcard = true;
+        } else {
+            newByte.nibble[j].wildcard = false;
+            newByte.nibble[j].data = HexChToInt(patterntext[i]) & 0xF;
+        }
+
+        j++;
+
+        if (j == 2) {
+            j = 0;
+            pattern.push_back(newByte);
+        }
+    }
+    return true;
+}
+
+static bool MatchByte(const unsigned char byte, const PatternByte& pbyte) {
+    int matched = 0;
+
+    unsigned char n1 = (byte >> 4) & 0xF;
+    if (pbyte.nibble[0].wildcard)
+        matched++;
+    else if (pbyte.nibble[0].data == n1)
+        matched++;
+
+    unsigned char n2 = byte & 0xF;
+    if (pbyte.nibble[1].wildcard)
+        matched++;
+    else if (pbyte.nibble[1].data == n2)
+        matched++;
+
+    return (matched == 2);
+}
+
+static uintptr_t FindPattern(const unsigned char* dataStart, const unsigned char* dataEnd, string_view pszPattern,
+                             uintptr_t baseAddress, size_t offset, int occurrence) {
+    vector<PatternByte> patterndata;
+    if (!TransformPattern(pszPattern, patterndata)) return 0;
+
+    int resultCount = 0;
+    const unsigned char* scanStart = dataStart;
+
+    while (true) {
+        const unsigned char* ret = search(scanStart, dataEnd, patterndata.begin(), patterndata.end(), MatchByte);
+        if (ret == dataEnd) break;
+
+        if (occurrence == 0 || resultCount == occurrence) return baseAddress + distance(dataStart, ret) + offset;
+
+        resultCount++;
+        scanStart = ++ret;
+    }
+
+    return 0;
+}
+
+}  // namespace legacy
+
+struct Job {
+    string name;
+    string pattern;
+    int occurrence = 0;
+};
+
+static void CollectJobs(const cJSON* signatures, vector<Job>& jobs) {
+    const cJSON* category;
+    cJSON_ArrayForEach(category, signatures) {
+        const cJSON* signature;
+        cJSON_ArrayForEach(signature, category) {
+            string name = string(category->string) + "/" + signature->string;
+
+            const cJSON* pattern = cJSON_GetObjectItemCaseSensitive(signature, "pattern");
+            if (cJSON_IsString(pattern)) {
+                const cJSON* occurrence = cJSON_GetObjectItemCaseSensitive(signature, "occurrence");
+                jobs.push_back({ name, pattern->valuestring, cJSON_IsNumber(occurrence) ? occurrence->valueint : 0 });
+            }
+
+            const cJSON* patterns = cJSON_GetObjectItemCaseSensitive(signature, "patterns");
+            const cJSON* element;
+            cJSON_ArrayForEach(element, patterns) {
+                if (cJSON_IsString(element)) jobs.push_back({ name, element->valuestring, 0 });
+            }
+        }
+    }
+}
+
+static bool ReadFile(const char* path, string& out) {
+    ifstream file(path, ios::binary);
+    if (!file) return false;
+    out.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+    return true;
+}
+
+template <typename F>
+static double Time(F&& func, int runs) {
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < runs; i++) func();
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count() / runs;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <text.bin> <gamedef.json | pattern...>\n", argv[0]);
+        return 1;
+    }
+
+    string text;
+    if (!ReadFile(argv[1], text)) {
+        fprintf(stderr, "could not read %s\n", argv[1]);
+        return 1;
+    }
+    const uint8_t* dataStart = reinterpret_cast<const uint8_t*>(text.data());
+    const uint8_t* dataEnd = dataStart + text.size();
+
+    vector<Job> jobs;
+    string gamedef;
+    if (argc == 3 && string_view(argv[2]).ends_with(".json") && ReadFile(argv[2], gamedef)) {
+        cJSON* root = cJSON_Parse(gamedef.c_str());
+        if (!root) {
+            fprintf(stderr, "could not parse %s\n", argv[2]);
+            return 1;
+        }
+        CollectJobs(cJSON_GetObjectItemCaseSensitive(root, "signatures"), jobs);
+        cJSON_Delete(root);
+    } else {
+        for (int i = 2; i < argc; i++) jobs.push_back({ argv[i], argv[i], 0 });
+    }
+
+    // Short scans are repeated so their timing means something
+    const int runs = text.size() < (16 << 20) ? 5 : 1;
+    double legacyTotal = 0, newTotal = 0;
+    int mismatches = 0;
+
+    vector<uintptr_t> results;
+
+    printf("%-48s %10s %10s %8s\n", "signature", "old (ms)", "new (ms)", "speedup");
+    for (const Job& job : jobs) {
+        uintptr_t expected = 0, actual = 0;
+        double legacyTime = Time([&] { expected = legacy::FindPattern(dataStart, dataEnd, job.pattern, 0, 0, job.occurrence); }, runs);
+        double newTime = Time([&] { actual = rd::hook::FindPattern(dataStart, dataEnd, job.pattern, 0, 0, job.occurrence); }, runs);
+
+        legacyTotal += legacyTime;
+        newTotal += newTime;
+
+        printf("%-48s %10.3f %10.3f %7.1fx", job.name.c_str(), legacyTime, newTime, legacyTime / newTime);
+        if (expected != actual) {
+            printf("  MISMATCH 0x%zx != 0x%zx", actual, expected);
+            mismatches++;
+        }
+        printf("\n");
+        results.push_back(expected);
+    }
+
+    printf("%-48s %10.3f %10.3f %7.1fx\n", "total", legacyTotal, newTotal, legacyTotal / newTotal);
+
+    // Everything at once, the way the module resolves the gamedef at startup
+    rd::hook::PatternSet batch;
+    for (const Job& job : jobs) batch.Add(job.pattern, job.occurrence + 1);
+
+    for (size_t workers = 1; workers <= rd::hook::PatternSet::MaxWorkers; workers++) {
+        double batchTime = Time([&] { batch.Scan(dataStart, dataEnd, 0, workers); }, runs);
+        printf("%-48s %10s %10.3f %7.1fx\n", ("batch, " + to_string(workers) + " worker(s)").c_str(), "", batchTime,
+               legacyTotal / batchTime);
+
+        for (size_t i = 0; i < jobs.size(); i++) {
+            auto matches = batch.Matches(i);
+            uintptr_t actual = static_cast<size_t>(jobs[i].occurrence) < matches.size() ? matches[jobs[i].occurrence] : 0;
+            if (actual != results[i]) {
+                printf("  MISMATCH %s: 0x%zx != 0x%zx\n", jobs[i].name.c_str(), actual, results[i]);
+                mismatches++;
+            }
+        }
+    }
+
+    if (mismatches) printf("%d mismatches\n", mismatches);
+    return mismatches ? 1 : 0;
+}
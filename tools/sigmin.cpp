@@ -0,0 +1,271 @@
+// Checks that every gamedef signature matches exactly once in a game's .text, and shortens each one to the
+// shortest run of its pattern, wildcards kept, that still only matches at the same place.
+// Usage: sigmin <main | module.bin> <gamedef.json> [--text-size <bytes>] [-o <minimized.json>]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "ModuleImage.h"
+#include "RegionalDialect/Pattern.h"
+#include "cJSON.h"
+
+using namespace std;
+using namespace rd::hook;
+
+// Shorter starting runs leave too many candidates to go through
+static constexpr size_t MinProbeSize = 4;
+
+static ModuleImage s_Image;
+
+template <typename F>
+static double Time(F&& func) {
+    auto start = chrono::steady_clock::now();
+    func();
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+// Every match of a pattern in .text
+static vector<const uint8_t*> FindAll(const PatternView& pattern) {
+    vector<const uint8_t*> matches;
+    PatternCursor cursor(pattern, s_Image.Text(), s_Image.TextEnd());
+    while (const uint8_t* match = cursor.Next()) matches.push_back(match);
+    return matches;
+}
+
+static double ScanTime(const PatternView& pattern) {
+    return Time([&] {
+        PatternCursor cursor(pattern, s_Image.Text(), s_Image.TextEnd());
+        while (cursor.Next()) {}
+    });
+}
+
+// Writes size bytes of a pattern from start the way the gamedef has them, as bytes with '?' for
+// wildcard nibbles or as instruction words with their masks
+static string Format(const PatternView& pattern, size_t start, size_t size) {
+    string text;
+    char buffer[32];
+
+    if (pattern.alignment == 4) {
+        for (size_t i = start; i < start + size; i += 4) {
+            uint32_t value, mask;
+            memcpy(&value, pattern.value + i, 4);
+            memcpy(&mask, pattern.mask + i, 4);
+
+            if (mask == UINT32_MAX) snprintf(buffer, sizeof(buffer), "%s%08X", text.empty() ? "" : " ", value);
+            else snprintf(buffer, sizeof(buffer), "%s%08X/%08X", text.empty() ? "" : " ", value, mask);
+            text += buffer;
+        }
+        return text;
+    }
+
+    const char* digits = "0123456789ABCDEF";
+    for (size_t i = start; i < start + size; i++) {
+        if (!text.empty()) text += ' ';
+        text += (pattern.mask[i] & 0xF0) ? digits[pattern.value[i] >> 4] : '?';
+        text += (pattern.mask[i] & 0x0F) ? digits[pattern.value[i] & 0xF] : '?';
+    }
+    return text;
+}
+
+static bool Compile(Pattern& pattern, string_view text, bool insns) {
+    return insns ? pattern.CompileInsns(text) : pattern.Compile(text);
+}
+
+struct Window {
+    size_t start = 0;
+    size_t size = 0;
+};
+
+// The shortest run of pattern that only matches at match + its start. Every start is tried: the run's first
+// MinProbeSize bytes are scanned for, then the candidates are narrowed down a byte (or word) at a time.
+static Window Minimize(const Pattern& pattern, const uint8_t* match) {
+    const PatternView& view = pattern.view;
+    size_t step = view.alignment;
+    Window best = { 0, view.size };
+
+    for (size_t start = 0; start + step <= view.size; start += step) {
+        // A run never starts with wildcards, they can only be trimmed off
+        bool wildcard = true;
+        for (size_t i = start; i < start + step; i++) wildcard &= view.mask[i] == 0;
+        if (wildcard) continue;
+
+        size_t probe = max(MinProbeSize, step);
+        if (start + probe > view.size || probe >= best.size) break;
+
+        Pattern prefix;
+        Compile(prefix, Format(view, start, probe), step == 4);
+        vector<const uint8_t*> candidates = FindAll(prefix.view);
+
+        size_t end = start + probe;
+        while (candidates.size() > 1 && end < view.size && end - start < best.size) {
+            size_t kept = 0;
+            for (const uint8_t* candidate : candidates) {
+                bool same = candidate + (end - start) + step <= s_Image.TextEnd();
+                for (size_t i = end; same && i < end + step; i++)
+                    same = (candidate[i - start] & view.mask[i]) == view.value[i];
+                if (same) candidates[kept++] = candidate;
+            }
+            candidates.resize(kept);
+            end += step;
+        }
+
+        if (candidates.size() != 1 || candidates.front() != match + start) continue;
+
+        // The probe may have been unique already, with wildcards at its end
+        while (end - start > step) {
+            bool trailing = true;
+            for (size_t i = end - step; i < end; i++) trailing &= view.mask[i] == 0;
+            if (!trailing) break;
+            end -= step;
+        }
+
+        // Byte patterns need a fully specified byte for the batch to anchor on
+        Pattern run;
+        Compile(run, Format(view, start, end - start), step == 4);
+        while (step == 1 && !run.view.hasAnchor && end < view.size) {
+            end++;
+            Compile(run, Format(view, start, end - start), false);
+        }
+
+        if (end - start < best.size) best = { start, end - start };
+    }
+
+    return best;
+}
+
+static void SetNumber(cJSON* object, const char* name, double value) {
+    if (cJSON_GetObjectItem(object, name)) cJSON_ReplaceItemInObject(object, name, cJSON_CreateNumber(value));
+    else cJSON_AddNumberToObject(object, name, value);
+}
+
+// Offsets can also be strings, so they can be written in hex
+static double ReadOffset(const cJSON* sig) {
+    const cJSON* offset = cJSON_GetObjectItem(sig, "offset");
+    if (cJSON_IsString(offset)) return (double)(int64_t)strtoll(offset->valuestring, nullptr, 0);
+    return offset ? cJSON_GetNumberValue(offset) : 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <main | module.bin> <gamedef.json> [--text-size <bytes>] [-o <minimized.json>]\n", argv[0]);
+        return 1;
+    }
+
+    size_t textSize = 0;
+    const char* outPath = nullptr;
+    for (int i = 3; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--text-size") == 0) textSize = strtoull(argv[++i], nullptr, 0);
+        else if (strcmp(argv[i], "-o") == 0) outPath = argv[++i];
+    }
+
+    string error;
+    if (!s_Image.Load(argv[1], textSize, error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+
+    vector<uint8_t> gamedef;
+    cJSON* root = ReadFile(argv[2], gamedef) ? cJSON_ParseWithLength((const char*)gamedef.data(), gamedef.size()) : nullptr;
+    if (!root) {
+        fprintf(stderr, "could not parse %s\n", argv[2]);
+        return 1;
+    }
+
+    printf("%-40s %8s %8s %8s %10s %10s\n", "signature", "matches", "before", "after", "scan (ms)", "after (ms)");
+
+    int failures = 0, minimized = 0;
+    double timeBefore = 0, timeAfter = 0;
+    PatternSet batchBefore, batchAfter;
+    deque<Pattern> kept;  // Batches reference the patterns, which a deque never moves
+
+    cJSON* category;
+    cJSON_ArrayForEach(category, cJSON_GetObjectItem(root, "signatures")) {
+        cJSON* sig;
+        cJSON_ArrayForEach(sig, category) {
+            string name = string(category->string) + "/" + sig->string;
+
+            const char* key = cJSON_GetObjectItem(sig, "insns") ? "insns" : "pattern";
+            const char* text = cJSON_GetStringValue(cJSON_GetObjectItem(sig, key));
+            bool insns = strcmp(key, "insns") == 0;
+
+            // Only signatures looked for in the whole of .text, taking their first match
+            const char* skipped = nullptr;
+            if (!text) skipped = cJSON_GetObjectItem(sig, "patterns") ? "array" : "no pattern";
+            else if (cJSON_GetObjectItem(sig, "segment") || cJSON_GetObjectItem(sig, "window") || cJSON_GetObjectItem(sig, "near"))
+                skipped = "scoped";
+            else if (cJSON_GetNumberValue(cJSON_GetObjectItem(sig, "occurrence")) > 0) skipped = "occurrence";
+            if (skipped) {
+                printf("%-40s %8s  (%s, left as is)\n", name.c_str(), "", skipped);
+                continue;
+            }
+
+            Pattern& pattern = kept.emplace_back();
+            if (!Compile(pattern, text, insns)) {
+                printf("%-40s %8s  MALFORMED\n", name.c_str(), "");
+                failures++;
+                continue;
+            }
+
+            vector<const uint8_t*> matches = FindAll(pattern.view);
+            double before = ScanTime(pattern.view);
+            timeBefore += before;
+            batchBefore.Add(pattern.view);
+
+            if (matches.size() != 1) {
+                printf("%-40s %8zu %8zu %8s %10.3f  %s\n", name.c_str(), matches.size(), pattern.view.size, "",
+                       before, matches.empty() ? "NOT FOUND" : "NOT UNIQUE");
+                timeAfter += before;
+                batchAfter.Add(pattern.view);
+                failures++;
+                continue;
+            }
+
+            Window window = Minimize(pattern, matches.front());
+            Pattern& shortened = kept.emplace_back();
+            Compile(shortened, Format(pattern.view, window.start, window.size), insns);
+            double after = ScanTime(shortened.view);
+            timeAfter += after;
+            batchAfter.Add(shortened.view);
+
+            printf("%-40s %8zu %8zu %8zu %10.3f %10.3f\n", name.c_str(), matches.size(), pattern.view.size, window.size,
+                   before, after);
+
+            if (window.size == pattern.view.size) continue;
+            minimized++;
+
+            // The result stays where it was, relative to a match that now starts further in
+            cJSON_ReplaceItemInObject(sig, key, cJSON_CreateString(Format(pattern.view, window.start, window.size).c_str()));
+            double offset = ReadOffset(sig) - (double)window.start;
+            if (offset != 0 || cJSON_GetObjectItem(sig, "offset")) SetNumber(sig, "offset", offset);
+        }
+    }
+
+    double batchTimeBefore = Time([&] { batchBefore.Scan(s_Image.Text(), s_Image.TextEnd(), s_Image.Address(s_Image.textStart)); });
+    double batchTimeAfter = Time([&] { batchAfter.Scan(s_Image.Text(), s_Image.TextEnd(), s_Image.Address(s_Image.textStart)); });
+
+    printf("\n%-40s %10s %10s\n", "", "before", "after");
+    printf("%-40s %10.3f %10.3f ms\n", "signatures scanned one at a time", timeBefore, timeAfter);
+    printf("%-40s %10.3f %10.3f ms\n", "batch scan", batchTimeBefore, batchTimeAfter);
+    printf("%d minimized, %d not found or not unique\n", minimized, failures);
+
+    if (outPath) {
+        char* json = cJSON_Print(root);
+        ofstream file(outPath);
+        file << json << '\n';
+        cJSON_free(json);
+
+        if (!file) {
+            fprintf(stderr, "could not write %s\n", outPath);
+            failures++;
+        }
+    }
+
+    cJSON_Delete(root);
+    return failures ? 1 : 0;
+}
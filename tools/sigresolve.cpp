@@ -0,0 +1,256 @@
+// Resolves every gamedef signature against a game's main module the way the module does at startup,
+// and reports what each one resolves to, how many times its pattern matches and what it costs to scan.
+// Addresses are reported with the module at ModuleImage::DefaultBase, like disassemblers load it.
+// Usage: sigresolve <main | module.bin> <gamedef.json> [--text-size <bytes>] [--xrefs-to <address>...]
+//                   [--save-offsets <offsets/build.txt>] [--trace <trace.json>]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "ModuleImage.h"
+#include "RegionalDialect/Signature.h"
+#include "RegionalDialect/Trace.h"
+#include "XRefIndex.h"
+
+using namespace std;
+using namespace rd::hook;
+
+static ModuleImage s_Image;
+
+// Expressions read the image as if it were the module in memory
+static bool ReadImage(uintptr_t address, void* out, size_t size) {
+    return s_Image.Read(address, out, size);
+}
+
+template <typename F>
+static double Time(F&& func) {
+    auto start = chrono::steady_clock::now();
+    func();
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+// Every match of a pattern within its signature's scope, found on its own, and how long that took
+static vector<uintptr_t> FindMatches(const CompiledSignature& sig, const CompiledPattern& compiled, double& time) {
+    const uint8_t* start = s_Image.Text();
+    const uint8_t* end = s_Image.TextEnd();
+    if (sig.Deferred()) {
+        start = s_Image.memory.data() + (sig.scanStart - s_Image.base);
+        end = s_Image.memory.data() + (sig.scanEnd - s_Image.base);
+    }
+
+    vector<uintptr_t> matches;
+    time = Time([&] {
+        PatternCursor cursor(compiled.pattern.view, start, end);
+        while (const uint8_t* match = cursor.Next()) matches.push_back(s_Image.base + (match - s_Image.memory.data()));
+    });
+    return matches;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        fprintf(stderr,
+                "usage: %s <main | module.bin> <gamedef.json> [--text-size <bytes>] [--xrefs-to <address>...]\n"
+                "       [--save-offsets <offsets/build.txt>] [--trace <trace.json>]\n",
+                argv[0]);
+        return 1;
+    }
+
+    size_t textSize = 0;
+    vector<uintptr_t> xrefTargets;
+    const char* offsetsPath = nullptr;
+    const char* tracePath = nullptr;
+    for (int i = 3; i + 1 < argc; i++) {
+        if (strcmp(argv[i], "--text-size") == 0) textSize = strtoull(argv[++i], nullptr, 0);
+        else if (strcmp(argv[i], "--xrefs-to") == 0) xrefTargets.push_back(strtoull(argv[++i], nullptr, 0));
+        else if (strcmp(argv[i], "--save-offsets") == 0) offsetsPath = argv[++i];
+        else if (strcmp(argv[i], "--trace") == 0) tracePath = argv[++i];
+    }
+
+    string error;
+    if (!s_Image.Load(argv[1], textSize, error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 1;
+    }
+    if (offsetsPath && !s_Image.nso) {
+        fprintf(stderr, "--save-offsets needs the main NSO to identify the build by\n");
+        return 1;
+    }
+
+    vector<uint8_t> gamedef;
+    cJSON* root = ReadFile(argv[2], gamedef) ? cJSON_ParseWithLength((const char*)gamedef.data(), gamedef.size()) : nullptr;
+    if (!root) {
+        fprintf(stderr, "could not parse %s\n", argv[2]);
+        return 1;
+    }
+
+    vector<string> errors;
+    vector<CompiledSignature> signatures = CompileSignatures(cJSON_GetObjectItem(root, "signatures"), errors);
+    for (const string& message : errors) fprintf(stderr, "%s", message.c_str());
+
+    PatternSet batch;
+    AddToBatch(signatures, batch);
+
+    double batchTime = Time([&] { batch.Scan(s_Image.Text(), s_Image.TextEnd(), s_Image.Address(s_Image.textStart), PatternSet::MaxWorkers); });
+
+    ModuleLayout layout = {
+        .memory = s_Image.memory.data(),
+        .base = s_Image.base,
+        .textStart = s_Image.Address(s_Image.textStart),
+        .textEnd = s_Image.Address(s_Image.textEnd),
+        .rodataStart = s_Image.Address(s_Image.textEnd),
+        .rodataEnd = s_Image.Address(s_Image.rodataEnd),
+        .dataStart = s_Image.Address(s_Image.dataStart),
+        .dataEnd = s_Image.Address(s_Image.dataEnd),
+    };
+
+    size_t compileErrors = errors.size();
+    double deferredTime = Time([&] { ResolveDeferred(signatures, batch, layout, ReadImage, errors); });
+    for (size_t i = compileErrors; i < errors.size(); i++) fprintf(stderr, "%s", errors[i].c_str());
+
+    printf(".text %#zx-%#zx, %zu signatures\n\n", layout.textStart, layout.textEnd, signatures.size());
+    printf("%-48s %12s %12s %8s %10s\n", "signature", "match", "result", "matches", "scan (ms)");
+
+    int failures = compileErrors, ambiguous = 0;
+    vector<pair<string, uintptr_t>> offsets;
+    vector<pair<string, uintptr_t>> matchOffsets;  // Lists of matches, see MaxPrecomputedMatches
+    double scanTotal = 0;
+
+    for (const CompiledSignature& sig : signatures) {
+        string name = string(sig.category) + "/" + string(sig.name);
+
+        // What SigScanExhaust, or SigScanArray for each pattern, returns in the module
+        vector<vector<uintptr_t>> matches;
+        size_t count = 0;
+        double time = 0;
+        for (const CompiledPattern& compiled : sig.patterns) {
+            double patternTime;
+            matches.push_back(FindMatches(sig, compiled, patternTime));
+            count += matches.back().size();
+            time += patternTime;
+        }
+        scanTotal += time;
+
+        if (sig.xref.kind == SigXRef::Kind::To) {
+            matches = { sig.deferredMatches };
+            count = sig.deferredMatches.size();
+        }
+        if (sig.xref.kind == SigXRef::Kind::From) {
+            matches = { {} };
+            if (sig.deferredMatch != 0) matches[0].push_back(sig.deferredMatch - sig.offset);
+            count = sig.deferredMatch != 0;
+        }
+
+        for (size_t i = 0; i < matches.size(); i++) {
+            if (matches[i].size() > MaxPrecomputedMatches) continue;
+
+            char symbol[256];
+            auto add = [&](size_t index, uintptr_t offset) {
+                int length = PrecomputedMatchSymbol(symbol, sizeof(symbol), sig, i, index);
+                if (length > 0 && (size_t)length < sizeof(symbol)) matchOffsets.emplace_back(symbol, offset);
+            };
+
+            // Reloc tables only have room for offsets into the module below 256 MiB
+            bool fits = all_of(matches[i].begin(), matches[i].end(), [](uintptr_t match) {
+                return match >= s_Image.base && match - s_Image.base < (1u << 28);
+            });
+            if (!fits) continue;
+
+            add(SIZE_MAX, matches[i].size());
+            for (size_t k = 0; k < matches[i].size(); k++) add(k, matches[i][k] - s_Image.base);
+        }
+
+        if (sig.isArray) {
+            const char* note = count == 0 ? "  NOT FOUND" : "";
+            printf("%-48s %12s %12s %8zu %10.3f%s\n", name.c_str(), "(array)", "", count, time, note);
+            failures += count == 0;
+            continue;
+        }
+
+        uintptr_t match = ResolveMatch(sig, batch);
+        uintptr_t result = match;
+        string note;
+
+        if (match == 0) {
+            note = "  NOT FOUND";
+            failures++;
+        } else if (!sig.expr.Empty() && !sig.expr.Eval(match, ReadImage, result, error)) {
+            note = "  " + error.substr(0, error.find('\n'));
+            failures++;
+        } else if (sig.occurrence == 0 && count > 1) {
+            note = "  NOT UNIQUE";
+            ambiguous++;
+        }
+
+        printf("%-48s %#12zx %#12zx %8zu %10.3f%s\n", name.c_str(), match, result, count, time, note.c_str());
+
+        // Reloc tables only have room for offsets into the module below 256 MiB
+        if (note.empty() || note == "  NOT UNIQUE") {
+            if (result >= s_Image.base && result - s_Image.base < (1u << 28)) offsets.emplace_back(name, result - s_Image.base);
+            else fprintf(stderr, "%s resolves outside the module and is left to be scanned for\n", name.c_str());
+        }
+    }
+
+    printf("\n%-48s %10.3f ms\n", "signatures scanned one at a time", scanTotal);
+    printf("%-48s %10.3f ms\n", "batch scan", batchTime);
+    printf("%-48s %10.3f ms\n", "scoped signatures and xrefs", deferredTime);
+    printf("%d failed, %d not unique\n", failures, ambiguous);
+
+    if (offsetsPath) {
+        ofstream file(offsetsPath);
+        file << "# " << argv[1] << " resolved with " << argv[2] << " by sigresolve --save-offsets\n";
+
+        char line[64];
+        snprintf(line, sizeof(line), "build %#010x\n", s_Image.BuildHash());
+        file << line;
+        for (const auto& [name, offset] : offsets) {
+            snprintf(line, sizeof(line), " 0x%zx\n", offset);
+            file << name << line;
+        }
+        for (const auto& [name, offset] : matchOffsets) {
+            snprintf(line, sizeof(line), " 0x%zx\n", offset);
+            file << name << line;
+        }
+
+        if (!file) {
+            fprintf(stderr, "could not write %s\n", offsetsPath);
+            failures++;
+        } else {
+            printf("\nsaved %zu offsets and %zu listed matches for build %#010x to %s\n", offsets.size(),
+                   matchOffsets.size(), s_Image.BuildHash(), offsetsPath);
+        }
+    }
+
+    if (tracePath) {
+        FILE* file = fopen(tracePath, "w");
+        auto write = [](void* context, const char* data, size_t size) {
+            return fwrite(data, 1, size, static_cast<FILE*>(context)) == size;
+        };
+        bool written = file && rd::trace::WriteJson(write, file);
+        if (file && fclose(file) != 0) written = false;
+        if (!written) {
+            fprintf(stderr, "could not write %s\n", tracePath);
+            failures++;
+        }
+    }
+
+    if (!xrefTargets.empty()) {
+        XRefIndex xrefs;
+        xrefs.Build(s_Image.Text(), s_Image.TextEnd(), layout.textStart);
+        printf("\n%zu ADRP references in .text\n", xrefs.Size());
+
+        for (uintptr_t target : xrefTargets) {
+            printf("references to %#zx:\n", target);
+            for (const XRef& xref : xrefs.To(target))
+                printf("  adrp %#10zx  use %#10zx\n", xrefs.Address(xref.adrp), xrefs.Address(xref.use));
+        }
+    }
+
+    cJSON_Delete(root);
+    return failures ? 1 : 0;
+}